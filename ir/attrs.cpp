@@ -35,6 +35,8 @@ ostream& operator<<(ostream &os, const FnAttrs &attr) {
     os << " nowrite";
   if (attr.has(FnAttrs::ArgMemOnly))
     os << " argmemonly";
+  if (attr.has(FnAttrs::InaccessibleMemOnly))
+    os << " inaccessiblememonly";
   if (attr.has(FnAttrs::NNaN))
     os << " NNaN";
   if (attr.has(FnAttrs::NoReturn))
@@ -46,7 +46,8 @@ public:
   enum Attribute { None = 0, NoRead = 1 << 0, NoWrite = 1 << 1,
                    ArgMemOnly = 1 << 2, NNaN = 1 << 3, NoReturn = 1 << 4,
                    Dereferenceable = 1 << 5, NonNull = 1 << 6,
-                   NoFree = 1 << 7, NoUndef = 1 << 8 };
+                   NoFree = 1 << 7, NoUndef = 1 << 8,
+                   InaccessibleMemOnly = 1 << 9 };
 
   FnAttrs(unsigned bits = None) : bits(bits) {}
 
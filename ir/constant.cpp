@@ -16,6 +16,10 @@ void Constant::print(ostream &os) const {
   UNREACHABLE();
 }
 
+expr Constant::getConstValue() const {
+  return {};
+}
+
 
 IntConst::IntConst(Type &type, int64_t val)
   : Constant(type, to_string(val)), val(val) {}
@@ -29,6 +33,12 @@ StateValue IntConst::toSMT(State &s) const {
   return { expr::mkInt(get<string>(val).c_str(), bits()), true };
 }
 
+expr IntConst::getConstValue() const {
+  if (auto v = get_if<int64_t>(&val))
+    return expr::mkInt(*v, bits());
+  return expr::mkInt(get<string>(val).c_str(), bits());
+}
+
 expr IntConst::getTypeConstraints() const {
   unsigned min_bits = 0;
   if (auto v = get_if<int64_t>(&val))
@@ -75,6 +85,12 @@ StateValue ConstantInput::toSMT(State &s) const {
   return { expr::mkVar(getName().c_str(), type), true };
 }
 
+expr ConstantInput::getConstValue() const {
+  if (!getType().isIntType())
+    return {};
+  return expr::mkVar(getName().c_str(), bits());
+}
+
 expr ConstantInput::getTypeConstraints() const {
   return Value::getTypeConstraints() &&
          (getType().enforceIntType() || getType().enforceFloatType());
@@ -124,6 +140,28 @@ StateValue ConstantBinOp::toSMT(State &s) const {
   return { move(val), ap && bp };
 }
 
+expr ConstantBinOp::getConstValue() const {
+  auto a = lhs.getConstValue();
+  auto b = rhs.getConstValue();
+  if (!a.isValid() || !b.isValid())
+    return {};
+
+  switch (op) {
+  case ADD: return a + b;
+  case SUB: return a - b;
+  case SDIV:
+    if (!b.isConst() || b.isZero() ||
+        (b.isAllOnes() && (!a.isConst() || a.isSMin())))
+      return {};
+    return a.sdiv(b);
+  case UDIV:
+    if (!b.isConst() || b.isZero())
+      return {};
+    return a.udiv(b);
+  }
+  UNREACHABLE();
+}
+
 expr ConstantBinOp::getTypeConstraints() const {
   return Value::getTypeConstraints() &&
          getType().enforceIntType() &&
@@ -177,6 +215,21 @@ StateValue ConstantFn::toSMT(State &s) const {
   return { move(r), true };
 }
 
+expr ConstantFn::getConstValue() const {
+  switch (fn) {
+  case LOG2:
+    if (auto c = dynamic_cast<const Constant*>(args[0])) {
+      auto v = c->getConstValue();
+      if (v.isValid())
+        return v.log2(bits()).simplify();
+    }
+    return {};
+  case WIDTH:
+    return expr::mkUInt(args[0]->bits(), bits());
+  }
+  UNREACHABLE();
+}
+
 expr ConstantFn::getTypeConstraints() const {
   expr r = Value::getTypeConstraints();
   for (auto a : args) {
@@ -16,6 +16,10 @@ class Constant : public Value {
 public:
   Constant(Type &type, std::string &&name) : Value(type, std::move(name)) {}
   void print(std::ostream &os) const override;
+  // Returns the value of the constant under the current typing as a function
+  // of the constant inputs, or an invalid expression if it isn't an integer
+  // or may trigger UB.
+  virtual smt::expr getConstValue() const;
 };
 
 
@@ -27,6 +31,7 @@ public:
   IntConst(Type &type, std::string &&val);
   StateValue toSMT(State &s) const override;
   smt::expr getTypeConstraints() const override;
+  smt::expr getConstValue() const override;
   auto getInt() const { return std::get_if<int64_t>(&val); }
 };
 
@@ -47,6 +52,7 @@ public:
   ConstantInput(Type &type, std::string &&name)
     : Constant(type, std::move(name)) {}
   StateValue toSMT(State &s) const override;
+  smt::expr getConstValue() const override;
   smt::expr getTypeConstraints() const override;
 };
 
@@ -63,6 +69,7 @@ public:
   ConstantBinOp(Type &type, Constant &lhs, Constant &rhs, Op op);
   StateValue toSMT(State &s) const override;
   smt::expr getTypeConstraints() const override;
+  smt::expr getConstValue() const override;
 };
 
 
@@ -74,6 +81,7 @@ public:
   ConstantFn(Type &type, std::string_view name, std::vector<Value*> &&args);
   StateValue toSMT(State &s) const override;
   smt::expr getTypeConstraints() const override;
+  smt::expr getConstValue() const override;
 };
 
 struct ConstantFnException {
@@ -1611,7 +1611,9 @@ static void unpack_inputs(State &s, Value &argv, Type &ty,
 
       ptr_inputs.emplace_back(StateValue(p.release(), move(value.non_poison)),
                               argflag.has(ParamAttrs::ByVal),
-                              argflag.has(ParamAttrs::NoCapture));
+                              argflag.has(ParamAttrs::NoCapture),
+                              argflag.has(ParamAttrs::ReadOnly) ||
+                                argflag.has(ParamAttrs::ReadNone));
     } else {
       inputs.emplace_back(move(value));
     }
@@ -1795,6 +1797,8 @@ StateValue ICmp::toSMT(State &s) const {
       (elem_ty.isVectorType() &&
        elem_ty.getAsAggregateType()->getChild(0).isPtrType())) {
     fn = [&](auto &av, auto &bv, Cond cond) {
+      s.getMemory().usePtrInputs(av);
+      s.getMemory().usePtrInputs(bv);
       Pointer lhs(s.getMemory(), av);
       Pointer rhs(s.getMemory(), bv);
       switch (cond) {
@@ -1963,13 +1967,22 @@ StateValue Freeze::toSMT(State &s) const {
   auto &v = s[*val];
   s.resetUndefVars();
 
-  auto scalar = [&](auto &v, auto &np, auto &ty) -> StateValue {
+  // Values known to be non-poison in this path already have np = true (see
+  // State::ValueAnalysis), so those freezes are the identity.
+  // In tgt, nondet is existentially quantified in the refinement query, so it
+  // is left as a free variable. In src, it is universally quantified; we
+  // record it so the query can be first tried with it instantiated with the
+  // corresponding tgt value.
+  auto scalar = [&](auto &v, auto &np, auto &ty, unsigned idx) -> StateValue {
     if (np.isTrue())
       return { expr(v), expr(np) };
 
     StateValue ret_type = ty.getDummyValue(true);
     expr nondet = expr::mkFreshVar("nondet", ret_type.value);
-    s.addQuantVar(nondet);
+    if (s.isSource()) {
+      s.addQuantVar(nondet);
+      s.addFreezeVar(nondet, *this, idx);
+    }
     return { expr::mkIf(np, v, move(nondet)), move(ret_type.non_poison) };
   };
 
@@ -1982,11 +1995,11 @@ StateValue Freeze::toSMT(State &s) const {
       if (ty->isPadding(i))
         continue;
       auto vi = ty->extract(v, i);
-      vals.emplace_back(scalar(vi.value, vi.non_poison, ty->getChild(i)));
+      vals.emplace_back(scalar(vi.value, vi.non_poison, ty->getChild(i), i));
     }
     return ty->aggregateVals(vals);
   }
-  return scalar(v.value, v.non_poison, getType());
+  return scalar(v.value, v.non_poison, getType(), 0);
 }
 
 expr Freeze::getTypeConstraints(const Function &f) const {
@@ -2691,16 +2704,97 @@ void GEP::print(std::ostream &os) const {
   }
 }
 
+// Folds runs of constant indices into a single byte offset, so no terms are
+// built for them. For inbounds GEPs, only offsets with the same sign are
+// folded: the intermediate pointers are then in bounds and don't overflow if
+// the first and the last ones don't.
+static void fold_const_offsets(vector<pair<unsigned, StateValue>> &offsets,
+                               bool inbounds) {
+  auto fits = [](int64_t n) {
+    return bits_for_offset >= 64 ||
+           (n >= -(INT64_C(1) << (bits_for_offset - 1)) &&
+            n < (INT64_C(1) << (bits_for_offset - 1)));
+  };
+
+  vector<pair<unsigned, StateValue>> folded;
+  int64_t acc = 0;
+  bool has_acc = false;
+  auto flush = [&]() {
+    if (has_acc)
+      folded.emplace_back(1, StateValue(expr::mkInt(acc, bits_for_offset),
+                                        true));
+    has_acc = false;
+    acc = 0;
+  };
+
+  for (auto &off : offsets) {
+    auto &[sz, idx] = off;
+    if (!idx.non_poison.isTrue()) {
+      flush();
+      folded.emplace_back(move(off));
+      continue;
+    }
+    // a zero-sized step is a no-op
+    if (sz == 0)
+      continue;
+
+    int64_t n, inc, sum;
+    if (!idx.value.isInt(n) || !fits(n) ||
+        __builtin_mul_overflow(int64_t(sz), n, &inc) || !fits(inc)) {
+      flush();
+      folded.emplace_back(move(off));
+      continue;
+    }
+
+    if (inbounds && ((acc < 0 && inc > 0) || (acc > 0 && inc < 0)))
+      flush();
+
+    if (__builtin_add_overflow(acc, inc, &sum) || !fits(sum)) {
+      flush();
+      sum = inc;
+    }
+    acc = sum;
+    has_acc = true;
+  }
+  flush();
+  offsets = move(folded);
+}
+
 StateValue GEP::toSMT(State &s) const {
   auto scalar = [&](const StateValue &ptrval,
                     vector<pair<unsigned, StateValue>> &offsets) -> StateValue {
-    Pointer ptr(s.getMemory(), ptrval.value);
-    AndExpr non_poison(ptrval.non_poison);
+    fold_const_offsets(offsets, inbounds);
+
+    auto &cache = s.getGEPCache();
+    State::GEPKey key(ptrval.value,
+                      inbounds ? Pointer(s.getMemory(), ptrval.value)
+                                   .blockSize()
+                               : expr(),
+                      inbounds, {});
+    auto &prefix = get<3>(key);
+
+    // resume from the longest prefix of indices encoded before; all the
+    // shorter prefixes of an encoded GEP are in the cache as well
+    auto I = cache.find(key);
+    if (I == cache.end()) {
+      Pointer ptr(s.getMemory(), ptrval.value);
+      AndExpr non_poison;
+      if (inbounds)
+        non_poison.add(ptr.inbounds(true));
+      I = cache.emplace(key, make_pair(move(ptr), move(non_poison))).first;
+    }
 
-    if (inbounds)
-      non_poison.add(ptr.inbounds(true));
+    for (auto &off : offsets) {
+      prefix.emplace_back(off);
+      auto NI = cache.find(key);
+      if (NI != cache.end()) {
+        I = NI;
+        continue;
+      }
 
-    for (auto &[sz, idx] : offsets) {
+      Pointer ptr = I->second.first;
+      AndExpr non_poison = I->second.second;
+      auto &[sz, idx] = off;
       auto &[v, np] = idx;
       auto multiplier = expr::mkUInt(sz, bits_for_offset);
       auto val = v.sextOrTrunc(bits_for_offset);
@@ -2724,7 +2818,13 @@ StateValue GEP::toSMT(State &s) const {
 
       if (inbounds)
         non_poison.add(ptr.inbounds());
+
+      I = cache.emplace(key, make_pair(move(ptr), move(non_poison))).first;
     }
+
+    Pointer ptr = I->second.first;
+    AndExpr non_poison = I->second.second;
+    non_poison.add(ptrval.non_poison);
     return { ptr.release(), non_poison() };
   };
 
@@ -2986,6 +3086,20 @@ unique_ptr<Instr> Memcpy::dup(const string &suffix) const {
 
 
 
+// Returns a positive and a negative i32 of unspecified value, to be used as
+// the result of memcmp & friends
+static pair<expr, expr> mk_cmp_results(State &s, const char *name) {
+  auto z31 = expr::mkUInt(0, 31);
+  string name_nonzero = string(name) + "_nonzero";
+  expr pos = expr::mkFreshVar(name_nonzero.c_str(), z31);
+  s.addPre(pos != z31);
+  s.addQuantVar(pos);
+
+  expr neg = expr::mkFreshVar(name, z31);
+  s.addQuantVar(neg);
+  return { expr::mkUInt(0, 1).concat(pos), expr::mkUInt(1, 1).concat(neg) };
+}
+
 DEFINE_AS_RETZERO(Memcmp, getMaxAllocSize);
 DEFINE_AS_RETZERO(Memcmp, getMaxGEPOffset);
 DEFINE_AS_RETFALSE(Memcmp, canFree);
@@ -3034,21 +3148,15 @@ StateValue Memcmp::toSMT(State &s) const {
     s.addPre(result_var != zero);
     s.addQuantVar(result_var);
   } else {
-    auto z31 = expr::mkUInt(0, 31);
-    result_var = expr::mkFreshVar("memcmp_nonzero", z31);
-    s.addPre(result_var != z31);
-    s.addQuantVar(result_var);
-    result_var = expr::mkUInt(0, 1).concat(result_var);
-
-    result_var_neg = expr::mkFreshVar("memcmp", z31);
-    s.addQuantVar(result_var_neg);
-    result_var_neg = expr::mkUInt(1, 1).concat(result_var_neg);
+    tie(result_var, result_var_neg) = mk_cmp_results(s, "memcmp");
   }
 
   auto ith_exec =
       [&, this](unsigned i, bool is_last) -> tuple<expr, expr, AndExpr, expr> {
-    auto [val1, ub1] = s.getMemory().load((p1 + i)(), IntType("i8", 8), 1);
-    auto [val2, ub2] = s.getMemory().load((p2 + i)(), IntType("i8", 8), 1);
+    auto [val1, ub1]
+      = s.getMemory().load((p1 + i)(), IntType("i8", 8), 1, true);
+    auto [val2, ub2]
+      = s.getMemory().load((p2 + i)(), IntType("i8", 8), 1, true);
 
     AndExpr ub_and;
     ub_and.add(move(ub1));
@@ -3119,7 +3227,8 @@ StateValue Strlen::toSMT(State &s) const {
   auto ith_exec =
       [&s, &p, &ty](unsigned i, bool _) -> tuple<expr, expr, AndExpr, expr> {
     AndExpr ub;
-    auto [val, ub_load] = s.getMemory().load((p + i)(), IntType("i8", 8), 1);
+    auto [val, ub_load]
+      = s.getMemory().load((p + i)(), IntType("i8", 8), 1, true);
     ub.add(move(ub_load));
     ub.add(move(val.non_poison));
     return { expr::mkUInt(i, ty.bits()), true, move(ub), val.value != 0 };
@@ -3141,6 +3250,192 @@ unique_ptr<Instr> Strlen::dup(const string &suffix) const {
 }
 
 
+DEFINE_AS_RETZERO(Strcmp, getMaxAllocSize);
+DEFINE_AS_RETZERO(Strcmp, getMaxGEPOffset);
+DEFINE_AS_RETFALSE(Strcmp, canFree);
+
+uint64_t Strcmp::getMaxAccessSize() const {
+  uint64_t sz = max(getGlobalVarSize(ptr1), getGlobalVarSize(ptr2));
+  return num ? min(sz, getIntOr(*num, UINT64_MAX)) : sz;
+}
+
+MemInstr::ByteAccessInfo Strcmp::getByteAccessInfo() const {
+  return ByteAccessInfo::intOnly(1); /* strcmp raises UB on ptr bytes */
+}
+
+vector<Value*> Strcmp::operands() const {
+  if (num)
+    return { ptr1, ptr2, num };
+  return { ptr1, ptr2 };
+}
+
+void Strcmp::rauw(const Value &what, Value &with) {
+  RAUW(ptr1);
+  RAUW(ptr2);
+  RAUW(num);
+}
+
+void Strcmp::print(ostream &os) const {
+  os << getName() << " = " << (num ? "strncmp " : "strcmp ") << *ptr1 << ", "
+     << *ptr2;
+  if (num)
+    os << ", " << *num;
+}
+
+StateValue Strcmp::toSMT(State &s) const {
+  expr vptr1, vptr2, vnum;
+  if (num) {
+    vnum = s.getAndAddPoisonUB(*num).value;
+    auto &[v1, np1] = s[*ptr1];
+    auto &[v2, np2] = s[*ptr2];
+    s.addUB((vnum != 0).implies(np1 && np2));
+    vptr1 = v1;
+    vptr2 = v2;
+  } else {
+    vptr1 = s.getAndAddPoisonUB(*ptr1).value;
+    vptr2 = s.getAndAddPoisonUB(*ptr2).value;
+  }
+
+  Pointer p1(s.getMemory(), vptr1), p2(s.getMemory(), vptr2);
+  expr zero = expr::mkUInt(0, 32);
+  auto [result_pos, result_neg] = mk_cmp_results(s, "strcmp");
+
+  auto ith_exec =
+      [&, this](unsigned i, bool _) -> tuple<expr, expr, AndExpr, expr> {
+    auto [val1, ub1]
+      = s.getMemory().load((p1 + i)(), IntType("i8", 8), 1, true);
+    auto [val2, ub2]
+      = s.getMemory().load((p2 + i)(), IntType("i8", 8), 1, true);
+
+    AndExpr ub;
+    ub.add(move(ub1));
+    ub.add(move(ub2));
+    ub.add(move(val1.non_poison));
+    ub.add(move(val2.non_poison));
+
+    auto val_eq = val1.value == val2.value;
+    expr cont = val_eq && val1.value != 0;
+    if (num)
+      cont &= vnum.uge(i + 2);
+
+    return { expr::mkIf(val_eq, zero,
+                        expr::mkIf(val1.value.uge(val2.value), result_pos,
+                                   result_neg)),
+             true, move(ub), move(cont) };
+  };
+  auto [val, _, ub]
+    = LoopLikeFunctionApproximator(ith_exec).encode(s, strlen_unroll_cnt);
+
+  if (!num) {
+    s.addUB(move(ub));
+    return { move(val), true };
+  }
+  s.addUB((vnum != 0).implies(move(ub)));
+  return { expr::mkIf(vnum == 0, zero, move(val)), true };
+}
+
+expr Strcmp::getTypeConstraints(const Function &f) const {
+  return Value::getTypeConstraints() &&
+         ptr1->getType().enforcePtrType() &&
+         ptr2->getType().enforcePtrType() &&
+         (num ? num->getType().enforceIntType() : true) &&
+         getType().enforceIntType(32);
+}
+
+unique_ptr<Instr> Strcmp::dup(const string &suffix) const {
+  return make_unique<Strcmp>(getType(), getName() + suffix, *ptr1, *ptr2, num);
+}
+
+
+DEFINE_AS_RETZERO(Memchr, getMaxAllocSize);
+DEFINE_AS_RETFALSE(Memchr, canFree);
+
+uint64_t Memchr::getMaxAccessSize() const {
+  return num ? getIntOr(*num, UINT64_MAX) : getGlobalVarSize(ptr);
+}
+
+uint64_t Memchr::getMaxGEPOffset() const {
+  return getMaxAccessSize();
+}
+
+MemInstr::ByteAccessInfo Memchr::getByteAccessInfo() const {
+  return ByteAccessInfo::intOnly(1); /* memchr raises UB on ptr bytes */
+}
+
+vector<Value*> Memchr::operands() const {
+  if (num)
+    return { ptr, chr, num };
+  return { ptr, chr };
+}
+
+void Memchr::rauw(const Value &what, Value &with) {
+  RAUW(ptr);
+  RAUW(chr);
+  RAUW(num);
+}
+
+void Memchr::print(ostream &os) const {
+  os << getName() << " = " << (num ? "memchr " : "strchr ") << *ptr << ", "
+     << *chr;
+  if (num)
+    os << ", " << *num;
+}
+
+StateValue Memchr::toSMT(State &s) const {
+  expr vptr, vnum;
+  if (num) {
+    vnum = s.getAndAddPoisonUB(*num).value;
+    auto &[v, np] = s[*ptr];
+    s.addUB((vnum != 0).implies(np));
+    vptr = v;
+  } else {
+    vptr = s.getAndAddPoisonUB(*ptr).value;
+  }
+  // the character is converted to unsigned char
+  expr ch = s.getAndAddPoisonUB(*chr).value.trunc(8);
+
+  Pointer p(s.getMemory(), vptr);
+  expr null = Pointer::mkNullPointer(s.getMemory()).release();
+
+  auto ith_exec =
+      [&, this](unsigned i, bool _) -> tuple<expr, expr, AndExpr, expr> {
+    auto [val, ub_load]
+      = s.getMemory().load((p + i)(), IntType("i8", 8), 1, true);
+
+    AndExpr ub;
+    ub.add(move(ub_load));
+    ub.add(move(val.non_poison));
+
+    auto found = val.value == ch;
+    // strchr stops at the terminator, memchr after num bytes
+    expr cont = !found && (num ? vnum.uge(i + 2) : val.value != 0);
+    return { expr::mkIf(found, (p + i)(), null), true, move(ub),
+             move(cont) };
+  };
+  auto [val, _, ub]
+    = LoopLikeFunctionApproximator(ith_exec).encode(s, strlen_unroll_cnt);
+
+  if (!num) {
+    s.addUB(move(ub));
+    return { move(val), true };
+  }
+  s.addUB((vnum != 0).implies(move(ub)));
+  return { expr::mkIf(vnum == 0, null, move(val)), true };
+}
+
+expr Memchr::getTypeConstraints(const Function &f) const {
+  return Value::getTypeConstraints() &&
+         getType().enforcePtrType() &&
+         ptr->getType().enforcePtrType() &&
+         chr->getType().enforceIntType() &&
+         (num ? num->getType().enforceIntType() : true);
+}
+
+unique_ptr<Instr> Memchr::dup(const string &suffix) const {
+  return make_unique<Memchr>(getType(), getName() + suffix, *ptr, *chr, num);
+}
+
+
 vector<Value*> ExtractElement::operands() const {
   return { v, idx };
 }
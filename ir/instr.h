@@ -768,6 +768,52 @@ public:
 };
 
 
+// strcmp if num is null, strncmp otherwise
+class Strcmp final : public MemInstr {
+  Value *ptr1, *ptr2, *num;
+public:
+  Strcmp(Type &type, std::string &&name, Value &ptr1, Value &ptr2,
+         Value *num = nullptr)
+    : MemInstr(type, std::move(name)), ptr1(&ptr1), ptr2(&ptr2), num(num) {}
+
+  uint64_t getMaxAllocSize() const override;
+  uint64_t getMaxAccessSize() const override;
+  uint64_t getMaxGEPOffset() const override;
+  bool canFree() const override;
+  ByteAccessInfo getByteAccessInfo() const override;
+
+  std::vector<Value*> operands() const override;
+  void rauw(const Value &what, Value &with) override;
+  void print(std::ostream &os) const override;
+  StateValue toSMT(State &s) const override;
+  smt::expr getTypeConstraints(const Function &f) const override;
+  std::unique_ptr<Instr> dup(const std::string &suffix) const override;
+};
+
+
+// strchr if num is null, memchr otherwise
+class Memchr final : public MemInstr {
+  Value *ptr, *chr, *num;
+public:
+  Memchr(Type &type, std::string &&name, Value &ptr, Value &chr,
+         Value *num = nullptr)
+    : MemInstr(type, std::move(name)), ptr(&ptr), chr(&chr), num(num) {}
+
+  uint64_t getMaxAllocSize() const override;
+  uint64_t getMaxAccessSize() const override;
+  uint64_t getMaxGEPOffset() const override;
+  bool canFree() const override;
+  ByteAccessInfo getByteAccessInfo() const override;
+
+  std::vector<Value*> operands() const override;
+  void rauw(const Value &what, Value &with) override;
+  void print(std::ostream &os) const override;
+  StateValue toSMT(State &s) const override;
+  smt::expr getTypeConstraints(const Function &f) const override;
+  std::unique_ptr<Instr> dup(const std::string &suffix) const override;
+};
+
+
 class FnCall final : public MemInstr {
 private:
   std::string fnName;
@@ -7,6 +7,7 @@
 #include "ir/value.h"
 #include "smt/solver.h"
 #include "util/compiler.h"
+#include "util/config.h"
 #include <array>
 #include <numeric>
 #include <string>
@@ -51,16 +52,58 @@ static unsigned bits_ptr_byte_offset() {
   return bits_byte < bits_program_pointer ? 3 : 0;
 }
 
+// In the SoA layout, a byte is the concatenation of the fields stored in
+// each array:
+//   +-------------------------------------+-------------------+--------+
+//   | 1 | Pointer | byte offset           | non-poison bit(s) | data   |
+//   +-------------------------------------+-------------------+--------+
+// A pointer byte has its data zeroed, and its non-poison bits all equal,
+// while a non-pointer byte has its pointer fields zeroed.
+enum SoAField { SOA_DATA, SOA_NP, SOA_PTR };
+
+static unsigned bits_soa_field(SoAField f) {
+  switch (f) {
+  case SOA_DATA:
+    return Byte::bitsByte() - bits_soa_field(SOA_NP) - bits_soa_field(SOA_PTR);
+  case SOA_NP:
+    return does_int_mem_access ? bits_poison_per_byte : does_ptr_mem_access;
+  case SOA_PTR:
+    return does_ptr_mem_access *
+      (byte_has_ptr_bit() + Pointer::totalBits() + bits_ptr_byte_offset());
+  }
+  UNREACHABLE();
+}
+
 static unsigned padding_ptr_byte() {
+  if (config::memory_soa)
+    return Byte::bitsByte() - bits_soa_field(SOA_PTR);
   return Byte::bitsByte() - does_int_mem_access - 1 - Pointer::totalBits()
                           - bits_ptr_byte_offset();
 }
 
 static unsigned padding_nonptr_byte() {
+  if (config::memory_soa)
+    return 0;
   return
     Byte::bitsByte() - does_ptr_mem_access - bits_byte - bits_poison_per_byte;
 }
 
+static expr soa_field(const expr &byte, SoAField f) {
+  unsigned bits = bits_soa_field(f);
+  if (bits == 0)
+    return expr::mkUInt(0, 1); // placeholder for unused arrays
+  unsigned lo = 0;
+  for (unsigned i = 0; i < f; ++i) {
+    lo += bits_soa_field(SoAField(i));
+  }
+  return byte.extract(lo + bits - 1, lo);
+}
+
+// zero bits preceding the fields of a non-pointer byte
+static unsigned prefix_nonptr_byte() {
+  return config::memory_soa ? bits_soa_field(SOA_PTR) : byte_has_ptr_bit();
+}
+
 static expr concat_if(const expr &ifvalid, expr &&e) {
   return ifvalid.isValid() ? ifvalid.concat(e) : move(e);
 }
@@ -73,7 +116,7 @@ static string local_name(const State *s, const char *name) {
   return string(name) + (s->isSource() ? "_src" : "_tgt");
 }
 
-static int is_initial_memblock(const expr &e, bool match_any_init = false) {
+static bool is_initial_memblock(const expr &e) {
   string name;
   expr load, blk, idx;
   unsigned hi, lo;
@@ -82,10 +125,7 @@ static int is_initial_memblock(const expr &e, bool match_any_init = false) {
   else
     name = e.fn_name();
 
-  if (string_view(name).substr(0, 9) == "init_mem_")
-    return 1;
-
-  return match_any_init && string_view(name).substr(0, 8) == "blk_val!" ? 2 : 0;
+  return string_view(name).substr(0, 9) == "init_mem_";
 }
 
 static expr load_bv(const expr &var, const expr &idx0) {
@@ -96,8 +136,31 @@ static expr load_bv(const expr &var, const expr &idx0) {
   return var.lshr(idx).extract(0, 0) == 1;
 }
 
+// Only pointer inputs and blocks returned by loads/calls may be heap
+// allocated. The remaining non-local blocks are never freed.
+static bool nonlocal_may_be_freed(unsigned bid) {
+  return bid >= has_null_block + num_globals_src && bid < num_nonlocals_src;
+}
+
+static expr load_liveness(const vector<expr> &liveness, expr &bv_cache,
+                          const expr &bid) {
+  uint64_t n;
+  if (bid.isUInt(n))
+    return n < liveness.size() ? liveness[n] : false;
+
+  if (!bv_cache.isValid()) {
+    // bid 0 is the least significant bit
+    for (auto I = liveness.rbegin(), E = liveness.rend(); I != E; ++I) {
+      auto bit = I->toBVBool();
+      bv_cache = bv_cache.isValid() ? bv_cache.concat(bit) : move(bit);
+    }
+  }
+  return bv_cache.isValid() ? load_bv(bv_cache, bid) : false;
+}
+
 static void store_bv(Pointer &p, const expr &val, expr &local,
-                     expr &non_local, bool assume_local = false) {
+                     vector<expr> &non_local, expr &non_local_bv,
+                     bool assume_local = false) {
   auto bid0 = p.getShortBid();
 
   auto set = [&](const expr &var) {
@@ -114,7 +177,29 @@ static void store_bv(Pointer &p, const expr &val, expr &local,
 
   auto is_local = p.isLocal() || assume_local;
   local = expr::mkIf(is_local, set(local), local);
-  non_local = expr::mkIf(!is_local, set(non_local), non_local);
+
+  if (is_local.isTrue())
+    return;
+
+  auto update = [&](unsigned i) {
+    if (!nonlocal_may_be_freed(i))
+      return;
+    auto v = expr::mkIf(!is_local && bid0 == i, val, non_local[i]);
+    if (!v.eq(non_local[i])) {
+      non_local[i] = move(v);
+      non_local_bv = expr();
+    }
+  };
+
+  uint64_t n;
+  if (bid0.isUInt(n)) {
+    if (n < non_local.size())
+      update(n);
+    return;
+  }
+  for (unsigned i = 0, e = non_local.size(); i != e; ++i) {
+    update(i);
+  }
 }
 
 namespace IR {
@@ -136,6 +221,19 @@ Byte::Byte(const Pointer &ptr, unsigned i, const expr &non_poison)
 
   if (byte_has_ptr_bit())
     p = expr::mkUInt(1, 1);
+
+  if (config::memory_soa) {
+    auto np_bits = bits_soa_field(SOA_NP);
+    p = concat_if(p, expr(ptr()));
+    if (bits_ptr_byte_offset())
+      p = p.concat(expr::mkUInt(i, bits_ptr_byte_offset()));
+    p = p.concat(expr::mkIf(non_poison, expr::mkUInt(0, np_bits),
+                            expr::mkInt(-1, np_bits)))
+         .concat_zeros(bits_soa_field(SOA_DATA));
+    assert(!p.isValid() || p.bits() == bitsByte());
+    return;
+  }
+
   p = concat_if(p,
                 expr::mkIf(non_poison, expr::mkUInt(0, 1), expr::mkUInt(1, 1)))
       .concat(ptr());
@@ -154,8 +252,8 @@ Byte::Byte(const Memory &m, const expr &data, const expr &non_poison) : m(m) {
     return;
   }
 
-  if (byte_has_ptr_bit())
-    p = expr::mkUInt(0, 1);
+  if (auto prefix = prefix_nonptr_byte())
+    p = expr::mkUInt(0, prefix);
   p = concat_if(p, non_poison.concat(data).concat_zeros(padding_nonptr_byte()));
   assert(!p.isValid() || p.bits() == bitsByte());
 }
@@ -172,7 +270,9 @@ expr Byte::isPtr() const {
 expr Byte::ptrNonpoison() const {
   if (!does_ptr_mem_access)
     return true;
-  auto bit = p.bits() - 1 - byte_has_ptr_bit();
+  auto bit = config::memory_soa
+               ? bits_soa_field(SOA_DATA) + bits_soa_field(SOA_NP) - 1
+               : p.bits() - 1 - byte_has_ptr_bit();
   return p.extract(bit, bit) == 0;
 }
 
@@ -231,11 +331,14 @@ unsigned Byte::bitsByte() {
                         (1 + Pointer::totalBits() + bits_ptr_byte_offset());
   unsigned int_bits = does_int_mem_access * (bits_byte + bits_poison_per_byte);
   // allow at least 1 bit if there's no memory access
+  if (config::memory_soa)
+    return max(1u, bits_soa_field(SOA_PTR) + bits_soa_field(SOA_NP) +
+                   does_int_mem_access * bits_byte);
   return max(1u, byte_has_ptr_bit() + max(ptr_bits, int_bits));
 }
 
 Byte Byte::mkPtrByte(const Memory &m, const expr &val) {
-  assert(does_ptr_mem_access);
+  assert(does_ptr_mem_access && !config::memory_soa);
   expr byte;
   if (byte_has_ptr_bit())
     byte = expr::mkUInt(1, 1);
@@ -247,8 +350,8 @@ Byte Byte::mkNonPtrByte(const Memory &m, const expr &val) {
   if (!does_int_mem_access)
     return { m, expr::mkUInt(0, bitsByte()) };
   expr byte;
-  if (byte_has_ptr_bit())
-    byte = expr::mkUInt(0, 1);
+  if (auto prefix = prefix_nonptr_byte())
+    byte = expr::mkUInt(0, prefix);
   return { m, concat_if(byte, expr(val)).concat_zeros(padding_nonptr_byte()) };
 }
 
@@ -402,12 +505,21 @@ static expr attr_to_bitvec(const ParamAttrs &attrs) {
 
 namespace IR {
 
+static expr attrs_or_zero(const expr &attrs) {
+  if (!bits_for_ptrattrs)
+    return {};
+  return attrs.isValid() ? attrs : expr::mkUInt(0, bits_for_ptrattrs);
+}
+
 Pointer::Pointer(const Memory &m, const char *var_name, const expr &local,
                  bool unique_name, bool align, const expr &attr) : m(m) {
   string name = var_name;
   if (unique_name)
     name += '!' + to_string(ptr_next_idx++);
 
+  // Built packed, such that the fields extracted from this pointer are
+  // structurally equal to those extracted after a load/store round-trip.
+  // ptr_alias is keyed by these.
   unsigned bits = totalBitsShort() + !align * zero_bits_offset();
   p = prepend_if(local.toBVBool(),
                  expr::mkVar(name.c_str(), bits), ptr_has_local_bit());
@@ -433,20 +545,67 @@ Pointer::Pointer(const Memory &m, unsigned bid, bool local)
 }
 
 Pointer::Pointer(const Memory &m, unsigned bid, bool local, const expr &offset)
-  : m(m), p(
-    prepend_if(expr::mkUInt(local, 1),
-               expr::mkUInt(bid, bits_shortbid())
-                 .concat(offset).concat_zeros(bits_for_ptrattrs),
-               ptr_has_local_bit())) {
+  : m(m),
+    bid(prepend_if(expr::mkUInt(local, 1), expr::mkUInt(bid, bits_shortbid()),
+                   ptr_has_local_bit())),
+    offset(offset), attrs(attrs_or_zero(expr())) {
   assert((local && bid < m.numLocals()) || (!local && bid < num_nonlocals));
-  assert(!offset.isValid() || p.bits() == totalBits());
+  assert(!offset.isValid() || offset.bits() == bits_for_offset);
 }
 
 Pointer::Pointer(const Memory &m, const expr &bid, const expr &offset,
-                 const expr &attr) : m(m), p(bid.concat(offset)) {
-  if (bits_for_ptrattrs)
-    p = p.concat(attr.isValid() ? attr : expr::mkUInt(0, bits_for_ptrattrs));
-  assert(!bid.isValid() || !offset.isValid() || p.bits() == totalBits());
+                 const expr &attr)
+  : m(m), bid(bid), offset(offset), attrs(attrs_or_zero(attr)) {
+  assert(!bid.isValid() || bid.bits() == bits_for_bid);
+  assert(!offset.isValid() || offset.bits() == bits_for_offset);
+}
+
+const expr& Pointer::bidField() const {
+  if (!bid.isValid() && p.isValid())
+    bid = p.extract(totalBits() - 1, bits_for_offset + bits_for_ptrattrs);
+  return bid;
+}
+
+const expr& Pointer::offsetField() const {
+  if (!offset.isValid() && p.isValid())
+    offset = p.extract(bits_for_offset + bits_for_ptrattrs - 1,
+                       bits_for_ptrattrs);
+  return offset;
+}
+
+const expr& Pointer::attrsField() const {
+  if (!attrs.isValid() && p.isValid() && bits_for_ptrattrs)
+    attrs = p.extract(bits_for_ptrattrs - 1, 0);
+  return attrs;
+}
+
+expr Pointer::extract(const expr &field, unsigned field_low, unsigned high,
+                      unsigned low) const {
+  if (field.isValid())
+    return field.extract(high - field_low, low - field_low);
+  return p.extract(high, low);
+}
+
+void Pointer::unpack(expr &&repr) {
+  p = move(repr);
+  assert(!p.isValid() || p.bits() == totalBits());
+  bid    = expr();
+  offset = expr();
+  attrs  = expr();
+}
+
+const expr& Pointer::operator()() const {
+  if (!p.isValid() && bid.isValid() && offset.isValid()) {
+    p = bid.concat(offset);
+    if (bits_for_ptrattrs)
+      p = p.concat(attrs);
+  }
+  return p;
+}
+
+expr Pointer::release() {
+  (*this)();
+  return move(p);
 }
 
 unsigned Pointer::totalBits() {
@@ -468,7 +627,7 @@ expr Pointer::isLocal(bool simplify) const {
     return true;
 
   auto bit = totalBits() - 1;
-  expr local = p.extract(bit, bit);
+  expr local = extract(bid, bits_for_offset + bits_for_ptrattrs, bit, bit);
 
   if (simplify && is_initial_memblock(local))
     return false;
@@ -477,16 +636,17 @@ expr Pointer::isLocal(bool simplify) const {
 }
 
 expr Pointer::getBid() const {
-  return p.extract(totalBits() - 1, bits_for_offset + bits_for_ptrattrs);
+  return bidField();
 }
 
 expr Pointer::getShortBid() const {
-  return p.extract(totalBits() - 1 - ptr_has_local_bit(),
-                   bits_for_offset + bits_for_ptrattrs);
+  return extract(bid, bits_for_offset + bits_for_ptrattrs,
+                 totalBits() - 1 - ptr_has_local_bit(),
+                 bits_for_offset + bits_for_ptrattrs);
 }
 
 expr Pointer::getOffset() const {
-  return p.extract(bits_for_offset + bits_for_ptrattrs - 1, bits_for_ptrattrs);
+  return offsetField();
 }
 
 expr Pointer::getOffsetSizet() const {
@@ -494,18 +654,19 @@ expr Pointer::getOffsetSizet() const {
 }
 
 expr Pointer::getShortOffset() const {
-  return p.extract(bits_for_offset + bits_for_ptrattrs - 1,
-                   bits_for_ptrattrs + zero_bits_offset());
+  return extract(offset, bits_for_ptrattrs,
+                 bits_for_offset + bits_for_ptrattrs - 1,
+                 bits_for_ptrattrs + zero_bits_offset());
 }
 
 expr Pointer::getAttrs() const {
-  return bits_for_ptrattrs ? p.extract(bits_for_ptrattrs - 1, 0) : expr();
+  return attrsField();
 }
 
 expr Pointer::getValue(const char *name, const FunctionExpr &local_fn,
                        const FunctionExpr &nonlocal_fn,
                        const expr &ret_type, bool src_name) const {
-  if (!p.isValid())
+  if (!bidField().isValid())
     return {};
 
   auto bid = getShortBid();
@@ -555,14 +716,15 @@ expr Pointer::blockSize() const {
 }
 
 expr Pointer::shortPtr() const {
-  auto off = zero_bits_offset();
-  return p.extract(totalBits() - 1 - ptr_has_local_bit(),
-                   bits_for_ptrattrs + off);
+  if (p.isValid())
+    return p.extract(totalBits() - 1 - ptr_has_local_bit(),
+                     bits_for_ptrattrs + zero_bits_offset());
+  return getShortBid().concat(getShortOffset());
 }
 
 Pointer Pointer::operator+(const expr &bytes) const {
-  return { m, getBid(), getOffset() + bytes.zextOrTrunc(bits_for_offset),
-           getAttrs() };
+  return { m, bidField(), offsetField() + bytes.zextOrTrunc(bits_for_offset),
+           attrsField() };
 }
 
 Pointer Pointer::operator+(unsigned bytes) const {
@@ -570,16 +732,67 @@ Pointer Pointer::operator+(unsigned bytes) const {
 }
 
 void Pointer::operator+=(const expr &bytes) {
-  p = (*this + bytes).p;
+  bidField();
+  attrsField();
+  offset = offsetField() + bytes.zextOrTrunc(bits_for_offset);
+  p = expr();
 }
 
 expr Pointer::addNoOverflow(const expr &offset) const {
   return getOffset().add_no_soverflow(offset);
 }
 
+// Returns true if the given block ids are syntactically known to differ:
+// either both are constants, or one is local and the other is not
+static bool different_bids(const expr &bid1, const expr &bid2) {
+  if (bid1.isConst() && bid2.isConst())
+    return !bid1.eq(bid2);
+
+  if (!ptr_has_local_bit())
+    return false;
+
+  auto bit = bid1.bits() - 1;
+  auto local1 = bid1.extract(bit, bit);
+  auto local2 = bid2.extract(bit, bit);
+  return local1.isConst() && local2.isConst() && !local1.eq(local2);
+}
+
+// Only a few leaves are inspected per pointer, as this is called for every
+// pointer comparison. Returns false if either pointer has more.
+static bool different_blocks(const Pointer &p1, const Pointer &p2) {
+  constexpr unsigned max_leafs = 8;
+  auto leafs = [](const expr &bid, vector<expr> &out) {
+    for (auto &leaf : allExprLeafs(bid)) {
+      if (out.size() == max_leafs)
+        return false;
+      out.emplace_back(leaf);
+    }
+    return true;
+  };
+
+  vector<expr> bids1, bids2;
+  if (!leafs(p1.getBid(), bids1) || !leafs(p2.getBid(), bids2))
+    return false;
+
+  for (auto &bid1 : bids1) {
+    for (auto &bid2 : bids2) {
+      if (!different_bids(bid1, bid2))
+        return false;
+    }
+  }
+  return true;
+}
+
 expr Pointer::operator==(const Pointer &rhs) const {
-  return p.extract(totalBits() - 1, bits_for_ptrattrs) ==
-         rhs.p.extract(totalBits() - 1, bits_for_ptrattrs);
+  // pointers to different blocks are never equal
+  if (different_blocks(*this, rhs))
+    return false;
+
+  auto strip = [](const Pointer &ptr) {
+    return ptr.p.isValid() ? ptr.p.extract(totalBits() - 1, bits_for_ptrattrs)
+                           : ptr.bid.concat(ptr.offset);
+  };
+  return strip(*this) == strip(rhs);
 }
 
 expr Pointer::operator!=(const Pointer &rhs) const {
@@ -591,6 +804,8 @@ StateValue Pointer::op(const Pointer &rhs) const {                          \
   /* Note that attrs are not compared. */                                   \
   expr nondet = expr::mkFreshVar("nondet", true);                           \
   m.state->addQuantVar(nondet);                                             \
+  if (different_blocks(*this, rhs))                                         \
+    return { move(nondet), true };                                          \
   return { expr::mkIf(getBid() == rhs.getBid(),                             \
                       getOffset().op(rhs.getOffset()), nondet), true };     \
 }
@@ -615,11 +830,12 @@ static expr inbounds(const Pointer &p, bool strict) {
 }
 
 expr Pointer::inbounds(bool simplify_ptr, bool strict) {
+  m.usePtrInputs(p);
   if (!simplify_ptr)
     return ::inbounds(*this, strict);
 
   DisjointExpr<expr> ret(expr(false)), all_ptrs;
-  for (auto &[ptr_expr, domain] : DisjointExpr<expr>(p, true, true)) {
+  for (auto &[ptr_expr, domain] : DisjointExpr<expr>((*this)(), true, true)) {
     expr inb = ::inbounds(Pointer(m, ptr_expr), strict);
     if (!inb.isFalse())
       all_ptrs.add(ptr_expr, domain);
@@ -628,9 +844,9 @@ expr Pointer::inbounds(bool simplify_ptr, bool strict) {
 
   // trim set of valid ptrs
   if (auto ptrs = all_ptrs())
-    p = *ptrs;
+    unpack(*move(ptrs));
   else
-    p = expr::mkUInt(0, totalBits());
+    unpack(expr::mkUInt(0, totalBits()));
 
   return *ret();
 }
@@ -668,12 +884,15 @@ expr Pointer::isAligned(unsigned align) {
     // observed, program shouldn't be able to distinguish this from checking
     // getAddress()
     auto zero = expr::mkUInt(0, bits);
-    auto newp = p.extract(totalBits() - 1, bits_for_ptrattrs + bits)
-                 .concat(zero);
-    if (bits_for_ptrattrs)
-      newp = newp.concat(getAttrs());
-    p = move(newp);
-    assert(!p.isValid() || p.bits() == totalBits());
+    if (p.isValid()) {
+      auto newp = p.extract(totalBits() - 1, bits_for_ptrattrs + bits)
+                   .concat(zero);
+      if (bits_for_ptrattrs)
+        newp = newp.concat(getAttrs());
+      unpack(move(newp));
+    } else {
+      this->offset = offset.extract(bits_for_offset - 1, bits).concat(zero);
+    }
     return { blk_align && offset.extract(bits - 1, 0) == zero };
   }
 
@@ -709,11 +928,12 @@ static pair<expr, expr> is_dereferenceable(Pointer &p,
 // When bytes is 0, pointer is always derefenceable
 AndExpr Pointer::isDereferenceable(const expr &bytes0, unsigned align,
                                    bool iswrite) {
+  m.usePtrInputs(p);
   expr bytes_off = bytes0.zextOrTrunc(bits_for_offset);
   expr bytes = bytes0.zextOrTrunc(bits_size_t);
   DisjointExpr<expr> UB(expr(false)), is_aligned(expr(false)), all_ptrs;
 
-  for (auto &[ptr_expr, domain] : DisjointExpr<expr>(p, true, true)) {
+  for (auto &[ptr_expr, domain] : DisjointExpr<expr>((*this)(), true, true)) {
     Pointer ptr(m, ptr_expr);
     auto [ub, aligned] = ::is_dereferenceable(ptr, bytes_off, bytes, align,
                                               iswrite);
@@ -738,9 +958,9 @@ AndExpr Pointer::isDereferenceable(const expr &bytes0, unsigned align,
 
   // trim set of valid ptrs
   if (auto ptrs = all_ptrs())
-    p = *ptrs;
+    unpack(*move(ptrs));
   else
-    p = expr::mkUInt(0, totalBits());
+    unpack(expr::mkUInt(0, totalBits()));
 
   return exprs;
 }
@@ -775,7 +995,8 @@ expr Pointer::isBlockAlive() const {
 
   auto bid = getShortBid();
   return mkIf_fold(isLocal(), load_bv(m.local_block_liveness, bid),
-                   load_bv(m.non_local_block_liveness, bid));
+                   load_liveness(m.non_local_block_liveness,
+                                 m.non_local_liveness_bv, bid));
 }
 
 expr Pointer::getAllocType() const {
@@ -858,25 +1079,27 @@ expr Pointer::isNocapture(bool simplify) const {
   if (isLocal(simplify).isTrue())
     return false;
 
-  return p.extract(0, 0) == 1;
+  return extract(attrs, 0, 0, 0) == 1;
 }
 
 expr Pointer::isReadonly() const {
   if (!has_readonly)
     return false;
-  return p.extract(has_nocapture, has_nocapture) == 1;
+  return extract(attrs, 0, has_nocapture, has_nocapture) == 1;
 }
 
 expr Pointer::isReadnone() const {
   if (!has_readnone)
     return false;
   unsigned idx = (unsigned)has_nocapture + (unsigned)has_readonly;
-  return p.extract(idx, idx) == 1;
+  return extract(attrs, 0, idx, idx) == 1;
 }
 
 void Pointer::stripAttrs() {
-  p = p.extract(totalBits()-1, bits_for_ptrattrs)
-       .concat_zeros(bits_for_ptrattrs);
+  bidField();
+  offsetField();
+  attrs = attrs_or_zero(expr());
+  p = expr();
 }
 
 Pointer Pointer::mkNullPointer(const Memory &m) {
@@ -899,7 +1122,7 @@ expr Pointer::isNonZero() const {
 }
 
 bool Pointer::operator<(const Pointer &rhs) const {
-  return p < rhs.p;
+  return (*this)() < rhs();
 }
 
 ostream& operator<<(ostream &os, const Pointer &p) {
@@ -1066,7 +1289,7 @@ void Memory::AliasSet::print(ostream &os) const {
 }
 
 
-static set<Pointer> all_leaf_ptrs(Memory &m, const expr &ptr) {
+static set<Pointer> all_leaf_ptrs(const Memory &m, const expr &ptr) {
   set<Pointer> ptrs;
   for (auto &ptr_val : allExprLeafs(ptr)) {
     Pointer p(m, ptr_val);
@@ -1132,12 +1355,10 @@ bool Memory::mayalias(bool local, unsigned bid0, const expr &offset0,
   } else if (local) // allocated in another branch
     return false;
 
-  // globals are always live
-  if (local || (bid0 >= num_globals_src && bid0 < num_nonlocals_src)) {
-    if ((local ? local_block_liveness : non_local_block_liveness)
-          .extract(bid0, bid0).isZero())
-      return false;
-  }
+  assert(local || bid0 < non_local_block_liveness.size());
+  if (local ? local_block_liveness.extract(bid0, bid0).isZero()
+            : non_local_block_liveness[bid0].isFalse())
+    return false;
 
   return true;
 }
@@ -1147,6 +1368,8 @@ void Memory::access(const Pointer &ptr, unsigned bytes, unsigned align,
                     bool write, Fn &fn) {
   assert(bytes % (bits_byte/8) == 0);
 
+  usePtrInputs(ptr());
+
   AliasSet aliasing(*this);
   auto sz_local = aliasing.size(true);
   auto sz_nonlocal = aliasing.size(false);
@@ -1325,7 +1548,12 @@ void Memory::store(const Pointer &ptr,
     // contents. Pick a value as the default one.
     if (Pointer(*this, bid, local).blockSize().isUInt(blk_size) &&
         blk_size == bytes) {
-      mem = expr::mkConstArray(offset, data[0].second);
+      // a full write is UB unless the offset is zero
+      vector<expr> contents(data.size());
+      for (auto &[idx, val] : data) {
+        contents[idx >> zero_bits_offset()] = val;
+      }
+      mem = BlockVal::mkConst(contents);
       full_write = true;
       if (cond.isTrue()) {
         blk.undef.clear();
@@ -1337,13 +1565,13 @@ void Memory::store(const Pointer &ptr,
       blk.type |= stored_ty;
     }
 
-    for (auto &[idx, val] : data) {
-      if (full_write && val.eq(data[0].second))
-        continue;
-      expr off = offset + expr::mkUInt(idx >> zero_bits_offset(), off_bits);
-      mem = mem.store(off, val);
+    if (!full_write) {
+      for (auto &[idx, val] : data) {
+        expr off = offset + expr::mkUInt(idx >> zero_bits_offset(), off_bits);
+        mem = mem.store(off, val);
+      }
     }
-    blk.val = expr::mkIf(cond, mem, blk.val);
+    blk.val = BlockVal::mkIf(cond, mem, blk.val);
     blk.undef.insert(undef.begin(), undef.end());
   };
 
@@ -1365,15 +1593,14 @@ void Memory::storeLambda(const Pointer &ptr, const expr &offset,
     // optimization: full rewrite
     if (bytes.eq(Pointer(*this, bid, local).blockSize())) {
       blk.val = val_no_offset
-        ? expr::mkIf(cond, expr::mkConstArray(offset, val), blk.val)
-        : expr::mkLambda(offset, expr::mkIf(cond, val, blk.val.load(offset)));
+        ? BlockVal::mkIf(cond, BlockVal::mkConst(val), blk.val)
+        : BlockVal::mkLambda(offset, cond, val, blk.val);
       if (cond.isTrue()) {
         blk.undef.clear();
         blk.type = stored_ty;
       }
     } else {
-      blk.val = expr::mkLambda(offset, expr::mkIf(cond && offset_cond, val,
-                                                  blk.val.load(offset)));
+      blk.val = BlockVal::mkLambda(offset, cond && offset_cond, val, blk.val);
     }
     blk.type |= stored_ty;
     blk.undef.insert(undef.begin(), undef.end());
@@ -1389,33 +1616,259 @@ static bool memory_unused() {
   return num_locals_src == 0 && num_locals_tgt == 0 && num_nonlocals == 0;
 }
 
-static expr mk_block_val_array(unsigned bid) {
-  auto str = "init_mem_" + to_string(bid);
-  return expr::mkArray(str.c_str(),
-                       expr::mkUInt(0, Pointer::bitsShortOffset()),
-                       expr::mkUInt(0, Byte::bitsByte()));
+static expr offset_sort() {
+  return expr::mkUInt(0, Pointer::bitsShortOffset());
 }
 
-static expr mk_liveness_array() {
-  if (!num_nonlocals)
-    return {};
+static unsigned num_block_arrays() {
+  return config::memory_soa ? 3 : 1;
+}
+
+template <typename Fn>
+static array<expr, 3> soa_map(Fn &&fn) {
+  array<expr, 3> ret;
+  for (auto f : { SOA_DATA, SOA_NP, SOA_PTR }) {
+    // unused arrays are all the same constant so they always compare equal
+    ret[f] = bits_soa_field(f)
+               ? fn(f) : expr::mkConstArray(offset_sort(), expr::mkUInt(0, 1));
+  }
+  return ret;
+}
+
+Memory::BlockVal Memory::BlockVal::mkConst(const expr &byte) {
+  if (!config::memory_soa)
+    return { { expr::mkConstArray(offset_sort(), byte) } };
+  return soa_map([&](SoAField f) {
+    return expr::mkConstArray(offset_sort(), soa_field(byte, f));
+  });
+}
+
+Memory::BlockVal Memory::BlockVal::mkConst(const vector<expr> &bytes) {
+  unsigned n = bytes.size();
+
+  // repeating pattern (e.g., an array with all elements equal): lambda over
+  // a lookup of the low bits of the offset
+  for (unsigned period = 2; period <= 16 && period < n; period *= 2) {
+    if (n % period != 0)
+      continue;
+
+    bool repeats = true;
+    for (unsigned i = period; repeats && i < n; ++i) {
+      repeats = bytes[i].eq(bytes[i % period]);
+    }
+    if (!repeats)
+      continue;
+
+    // not a fresh var so that the same initializer in src and tgt yields
+    // the same expression
+    auto offset = expr::mkVar("#off", offset_sort());
+    auto idx = offset.extract(ilog2(period) - 1, 0);
+    expr val = bytes[period - 1];
+    for (unsigned i = period - 1; i > 0; --i) {
+      val = expr::mkIf(idx == (i - 1), bytes[i - 1], val);
+    }
+    return mkLambda(offset, true, val, mkConst(bytes[0]));
+  }
+
+  // otherwise, only store the bytes that differ from the most common one
+  map<expr, unsigned> count;
+  const expr *common = &bytes[0];
+  for (auto &byte : bytes) {
+    if (++count[byte] > count[*common])
+      common = &byte;
+  }
+
+  auto ret = mkConst(*common);
+  for (unsigned i = 0; i < n; ++i) {
+    if (!bytes[i].eq(*common))
+      ret = ret.store(expr::mkUInt(i, offset_sort()), bytes[i]);
+  }
+  return ret;
+}
+
+Memory::BlockVal Memory::BlockVal::mkArray(const char *name) {
+  if (!config::memory_soa)
+    return { { expr::mkArray(name, offset_sort(),
+                             expr::mkUInt(0, Byte::bitsByte())) }, 1 };
+  return { soa_map([&](SoAField f) {
+    static const char *suffix[] = { "", "_np", "_ptr" };
+    auto str = string(name) + suffix[f];
+    return expr::mkArray(str.c_str(), offset_sort(),
+                         expr::mkUInt(0, bits_soa_field(f)));
+  }), 1 };
+}
+
+Memory::BlockVal Memory::BlockVal::mkFreshVar(const char *name) {
+  auto mk = [&](unsigned bits) {
+    return expr::mkFreshVar(name,
+             expr::mkConstArray(offset_sort(), expr::mkUInt(0, bits)));
+  };
+  if (!config::memory_soa)
+    return { { mk(Byte::bitsByte()) }, 2 };
+  return { soa_map([&](SoAField f) { return mk(bits_soa_field(f)); }), 2 };
+}
+
+Memory::BlockVal
+Memory::BlockVal::mkLambda(const expr &offset, const expr &cond,
+                           const expr &byte, const BlockVal &els) {
+  if (!config::memory_soa)
+    return { { expr::mkLambda(offset,
+                 expr::mkIf(cond, byte, els.arrays[0].load(offset))) } };
+  return soa_map([&](SoAField f) {
+    return expr::mkLambda(offset, expr::mkIf(cond, soa_field(byte, f),
+                                             els.arrays[f].load(offset)));
+  });
+}
+
+Memory::BlockVal Memory::BlockVal::mkIf(const expr &cond, const BlockVal &then,
+                                        const BlockVal &els) {
+  if (then.eq(els))
+    return then;
+
+  BlockVal ret;
+  for (unsigned i = 0, e = num_block_arrays(); i != e; ++i) {
+    ret.arrays[i] = expr::mkIf(cond, then.arrays[i], els.arrays[i]);
+  }
+  return ret;
+}
+
+Memory::BlockVal
+Memory::BlockVal::mapPtrs(const function<expr(const expr&)> &fn) const {
+  if (!does_ptr_mem_access)
+    return *this;
+
+  // not a fresh var so that mapping the same array in src and tgt yields
+  // the same expression
+  auto offset = expr::mkVar("#off", offset_sort());
+
+  // bytes: [..., pointer, ptr_lo bits]
+  auto map = [&](const expr &bytes, unsigned ptr_lo) {
+    unsigned bits = bytes.bits();
+    unsigned ptr_hi = ptr_lo + Pointer::totalBits() - 1;
+    expr ret = fn(bytes.extract(ptr_hi, ptr_lo));
+    if (ptr_hi + 1 < bits)
+      ret = bytes.extract(bits - 1, ptr_hi + 1).concat(ret);
+    if (ptr_lo > 0)
+      ret = ret.concat(bytes.extract(ptr_lo - 1, 0));
+    return ret;
+  };
+
+  BlockVal ret(*this);
+  if (config::memory_soa) {
+    // the pointer fields are only meaningful if the byte is a pointer
+    auto &ptrs = ret.arrays[SOA_PTR];
+    ptrs = expr::mkLambda(offset,
+                          map(ptrs.load(offset), bits_ptr_byte_offset()));
+  } else {
+    auto bytes = arrays[0].load(offset);
+    auto val = map(bytes, bits_ptr_byte_offset() + padding_ptr_byte());
+    if (byte_has_ptr_bit()) {
+      auto bit = bytes.bits() - 1;
+      val = expr::mkIf(bytes.extract(bit, bit) == 1, val, bytes);
+    }
+    ret.arrays[0] = expr::mkLambda(offset, val);
+  }
+  return ret;
+}
+
+expr Memory::BlockVal::load(const expr &offset) const {
+  if (!config::memory_soa)
+    return arrays[0].load(offset);
+
+  expr ret;
+  for (auto f : { SOA_PTR, SOA_NP, SOA_DATA }) {
+    if (bits_soa_field(f))
+      ret = concat_if(ret, arrays[f].load(offset));
+  }
+  return ret;
+}
+
+Memory::BlockVal
+Memory::BlockVal::store(const expr &offset, const expr &byte) const {
+  if (!config::memory_soa)
+    return { { arrays[0].store(offset, byte) } };
+
+  // storing the value already in a constant array is a no-op, so e.g.
+  // integer stores to blocks without pointers leave their array untouched
+  return soa_map([&](SoAField f) {
+    return arrays[f].store(offset, soa_field(byte, f));
+  });
+}
+
+int Memory::BlockVal::isInitial(bool match_any_init) const {
+  return initial == 2 && !match_any_init ? 0 : initial;
+}
+
+bool Memory::BlockVal::eqPtrFields(const BlockVal &rhs) const {
+  if (!config::memory_soa)
+    return eq(rhs);
+  return arrays[SOA_PTR].eq(rhs.arrays[SOA_PTR]) &&
+         arrays[SOA_NP].eq(rhs.arrays[SOA_NP]);
+}
+
+bool Memory::BlockVal::eqNonPtrFields(const BlockVal &rhs) const {
+  if (!config::memory_soa)
+    return eq(rhs);
+  return arrays[SOA_DATA].eq(rhs.arrays[SOA_DATA]) &&
+         arrays[SOA_NP].eq(rhs.arrays[SOA_NP]);
+}
+
+expr Memory::BlockVal::operator==(const BlockVal &rhs) const {
+  expr ret = true;
+  for (unsigned i = 0, e = num_block_arrays(); i != e; ++i) {
+    ret &= arrays[i] == rhs.arrays[i];
+  }
+  return ret;
+}
+
+bool Memory::BlockVal::eq(const BlockVal &rhs) const {
+  for (unsigned i = 0, e = num_block_arrays(); i != e; ++i) {
+    if (!arrays[i].eq(rhs.arrays[i]))
+      return false;
+  }
+  return true;
+}
+
+Memory::BlockVal Memory::BlockVal::simplify() const {
+  BlockVal ret;
+  ret.initial = initial;
+  for (unsigned i = 0, e = num_block_arrays(); i != e; ++i) {
+    ret.arrays[i] = arrays[i].simplify();
+  }
+  return ret;
+}
 
+bool Memory::BlockVal::operator<(const BlockVal &rhs) const {
+  return arrays < rhs.arrays;
+}
+
+void Memory::BlockVal::print(ostream &os) const {
+  if (!config::memory_soa) {
+    os << arrays[0];
+    return;
+  }
+  os << "data: " << arrays[SOA_DATA]
+     << "\tnon-poison: " << arrays[SOA_NP]
+     << "\tptr: " << arrays[SOA_PTR];
+}
+
+static vector<expr> mk_liveness_array() {
   // consider all non_locals are initially alive
   // block size can still be 0 to invalidate accesses
-  expr l = expr::mkInt(-1, num_nonlocals);
-  if (has_null_block)
-    l = l << expr::mkUInt(1, num_nonlocals);
+  vector<expr> l(num_nonlocals, true);
+  if (has_null_block && num_nonlocals)
+    l[0] = false;
   return l;
 }
 
-void Memory::mk_nonlocal_val_axioms(bool skip_consts) {
+void Memory::mk_nonlocal_val_axioms() {
   if (!does_ptr_mem_access)
     return;
 
   expr offset
     = expr::mkFreshVar("#off", expr::mkUInt(0, Pointer::bitsShortOffset()));
 
-  for (unsigned i = has_null_block + skip_consts * num_consts_src,
+  for (unsigned i = has_null_block,
        e = numNonlocals(); i != e; ++i) {
     Byte byte(*this, non_local_block_val[i].val.load(offset));
     Pointer loadedptr = byte.ptr();
@@ -1424,8 +1877,38 @@ void Memory::mk_nonlocal_val_axioms(bool skip_consts) {
       expr::mkForAll({ offset },
         byte.isPtr().implies(!loadedptr.isLocal(false) &&
                              !loadedptr.isNocapture(false) &&
-                             bid.ule(numNonlocals() - 1))));
-  }
+                             bid.ule(numNonlocals() - 1))),
+      "nonlocal-val");
+  }
+}
+
+// Non-local blocks cannot contain pointers to local blocks, no-capture
+// pointers, or pointers to blocks that don't exist. Rather than adding yet
+// another quantified axiom after each function call, the unconstrained
+// contents are mapped to well-formed ones. The map is the identity on
+// well-formed bytes, so no behavior is lost.
+Memory::BlockVal Memory::mkNonlocalBlockVal(BlockVal &&val) const {
+  uint64_t max_bid = numNonlocals() - 1;
+
+  return val.mapPtrs([&](const expr &ptrval) {
+    Pointer p(*this, ptrval);
+    expr short_bid = p.getShortBid();
+    auto bits = short_bid.bits();
+    if (bits < 64 && max_bid < (1ull << bits) - 1)
+      short_bid = expr::mkIf(short_bid.ule(max_bid), short_bid,
+                             expr::mkUInt(0, bits));
+    expr bid = prepend_if(expr::mkUInt(0, 1), move(short_bid),
+                          ptr_has_local_bit());
+
+    expr attrs = p.getAttrs();
+    if (has_nocapture) {
+      auto attr_bits = attrs.bits();
+      attrs = attr_bits == 1
+                ? expr::mkUInt(0, 1)
+                : attrs.extract(attr_bits - 1, 1).concat(expr::mkUInt(0, 1));
+    }
+    return Pointer(*this, bid, p.getOffset(), attrs).release();
+  });
 }
 
 Memory::Memory(State &state) : state(&state), escaped_local_blks(*this) {
@@ -1440,21 +1923,24 @@ Memory::Memory(State &state) : state(&state), escaped_local_blks(*this) {
 
   // TODO: should skip initialization of fully initialized constants
   for (unsigned bid = has_null_block, e = numNonlocals(); bid != e; ++bid) {
-    non_local_block_val.emplace_back(mk_block_val_array(bid));
+    auto str = "init_mem_" + to_string(bid);
+    non_local_block_val.emplace_back(BlockVal::mkArray(str.c_str()));
   }
 
   non_local_block_liveness = mk_liveness_array();
+  non_local_liveness_bv = expr();
 
   // Non-local blocks cannot initially contain pointers to local blocks
   // and no-capture pointers.
-  mk_nonlocal_val_axioms(false);
+  // This is stated once with axioms instead of using mkNonlocalBlockVal, as
+  // wrapping the initial arrays in lambdas makes the quantified memory
+  // refinement queries much harder.
+  mk_nonlocal_val_axioms();
 
   // initialize all local blocks as non-pointer, poison value
   // This is okay because loading a pointer as non-pointer is also poison.
   if (numLocals() > 0) {
-    auto poison_array
-      = expr::mkConstArray(expr::mkUInt(0, Pointer::bitsShortOffset()),
-                           Byte::mkPoisonByte(*this)());
+    auto poison_array = BlockVal::mkConst(Byte::mkPoisonByte(*this)());
     local_block_val.resize(numLocals(), { move(poison_array), DATA_NONE });
 
     // all local blocks are dead in the beginning
@@ -1496,16 +1982,18 @@ void Memory::mkAxioms(const Memory &tgt) const {
     auto p_align = p.blockAlignment();
     auto q_align = q.blockAlignment();
     state->addAxiom(
-      p.isHeapAllocated().implies(p_align == align && q_align == align));
+      p.isHeapAllocated().implies(p_align == align && q_align == align),
+      "block-align");
     if (!p_align.isConst() || !q_align.isConst())
-      state->addAxiom(p_align.ule(q_align));
+      state->addAxiom(p_align.ule(q_align), "block-align");
   }
 
   if (!observes_addresses())
     return;
 
   if (has_null_block)
-    state->addAxiom(Pointer::mkNullPointer(*this).getAddress(false) == 0);
+    state->addAxiom(Pointer::mkNullPointer(*this).getAddress(false) == 0,
+                    "null-addr");
 
   // Non-local blocks are disjoint.
   // Ignore null pointer block
@@ -1517,7 +2005,7 @@ void Memory::mkAxioms(const Memory &tgt) const {
     auto addr = p1.getAddress();
     auto sz = p1.blockSize();
 
-    state->addAxiom(addr != 0);
+    state->addAxiom(addr != 0, "nonlocal-addr");
 
     // Ensure block doesn't spill to local memory
     auto bit = bits_size_t - 1;
@@ -1531,7 +2019,7 @@ void Memory::mkAxioms(const Memory &tgt) const {
       disj &= p2.isBlockAlive()
                 .implies(disjoint(addr, sz, p2.getAddress(), p2.blockSize()));
     }
-    state->addAxiom(p1.isBlockAlive().implies(disj));
+    state->addAxiom(p1.isBlockAlive().implies(disj), "nonlocal-disjoint");
   }
 
   // ensure locals fit in their reserved space
@@ -1582,21 +2070,35 @@ expr Memory::mkInput(const char *name, const ParamAttrs &attrs) {
   Pointer p(*this, name, false, false, false, attr_to_bitvec(attrs));
   auto bid = p.getShortBid();
   if (attrs.has(ParamAttrs::NonNull))
-    state->addAxiom(p.isNonZero());
-  state->addAxiom(bid.ule(max_bid));
+    state->addAxiom(p.isNonZero(), "input-nonnull");
+  state->addAxiom(bid.ule(max_bid), "input-bid");
 
   AliasSet alias(*this);
   alias.setMayAliasUpTo(false, max_bid);
 
+  AndExpr not_byval;
   for (auto byval_bid : byval_blks) {
-    state->addAxiom(bid != byval_bid);
+    not_byval.add(bid != byval_bid);
     alias.setNoAlias(false, byval_bid);
   }
+  if (not_byval)
+    state->addPtrInputAxiom(p.getBid(), move(not_byval), "input-bid");
   ptr_alias.emplace(p.getBid(), move(alias));
 
   return p.release();
 }
 
+void Memory::usePtrInputs(const expr &ptr) const {
+  if (!state->hasPtrInputAxioms())
+    return;
+
+  for (auto &ptr_val : allExprLeafs(ptr)) {
+    for (auto &bid : allExprLeafs(Pointer(*this, ptr_val).getBid())) {
+      state->usePtrInput(bid);
+    }
+  }
+}
+
 pair<expr, expr> Memory::mkUndefInput(const ParamAttrs &attrs) const {
   bool nonnull = attrs.has(ParamAttrs::NonNull);
   unsigned log_offset = ilog2_ceil(bits_for_offset, false);
@@ -1655,7 +2157,8 @@ Memory::mkFnRet(const char *name, const vector<PtrInput> &ptr_inputs) {
   }
   ptr_alias.emplace(p.getBid(), move(alias));
 
-  state->addAxiom(expr::mkIf(p.isLocal(), expr::mk_or(local), nonlocal));
+  state->addAxiom(expr::mkIf(p.isLocal(), expr::mk_or(local), nonlocal),
+                  "fnret-bid");
   return { p.release(), move(var) };
 }
 
@@ -1665,12 +2168,14 @@ Memory::CallState Memory::CallState::mkIf(const expr &cond,
   CallState ret;
   for (unsigned i = 0, e = then.non_local_block_val.size(); i != e; ++i) {
     ret.non_local_block_val.emplace_back(
-      expr::mkIf(cond, then.non_local_block_val[i],
-                 els.non_local_block_val[i]));
+      BlockVal::mkIf(cond, then.non_local_block_val[i],
+                     els.non_local_block_val[i]));
+  }
+  for (unsigned i = 0, e = then.non_local_block_liveness.size(); i != e; ++i) {
+    ret.non_local_block_liveness.emplace_back(
+      expr::mkIf(cond, then.non_local_block_liveness[i],
+                 els.non_local_block_liveness[i]));
   }
-  ret.non_local_block_liveness
-    = expr::mkIf(cond, then.non_local_block_liveness,
-                 els.non_local_block_liveness);
   return ret;
 }
 
@@ -1685,56 +2190,85 @@ Memory::mkCallState(const vector<PtrInput> *ptr_inputs, bool nofree) const {
 
   // TODO: handle havoc of local blocks
 
-  auto blk_type = mk_block_val_array(1);
-  unsigned num_consts = has_null_block + num_consts_src;
-  for (unsigned i = num_consts; i < num_nonlocals_src; ++i) {
-    st.non_local_block_val.emplace_back(expr::mkFreshVar("blk_val", blk_type));
+  // Over-approximate the non-local blocks that the callee may write or free
+  // through its pointer arguments. If it may access any block, all are marked.
+  vector<bool> may_write_blk(num_nonlocals, !ptr_inputs);
+  vector<bool> may_free_blk(num_nonlocals, !ptr_inputs);
+  if (ptr_inputs) {
+    unsigned max_bid = min(next_nonlocal_bid, num_nonlocals);
+    for (auto &ptr_in : *ptr_inputs) {
+      usePtrInputs(ptr_in.val.value);
+      if (ptr_in.byval || ptr_in.val.non_poison.isFalse())
+        continue;
+
+      auto mark = [&](unsigned bid) {
+        may_free_blk[bid] = true;
+        if (!ptr_in.readonly)
+          may_write_blk[bid] = true;
+      };
+
+      for (auto &p : all_leaf_ptrs(*this, ptr_in.val.value)) {
+        if (p.isLocal().isTrue())
+          continue;
+
+        uint64_t bid;
+        if (p.getShortBid().isUInt(bid)) {
+          if (bid < max_bid)
+            mark(bid);
+          continue;
+        }
+
+        auto I = ptr_alias.find(p.getBid());
+        for (unsigned bid = has_null_block; bid < max_bid; ++bid) {
+          if (I == ptr_alias.end() || bid >= I->second.size(false) ||
+              I->second.mayAlias(false, bid))
+            mark(bid);
+        }
+      }
+    }
   }
 
-  if (ptr_inputs) {
-    for (unsigned bid = num_consts; bid < num_nonlocals_src; ++bid) {
+  unsigned num_consts = has_null_block + num_consts_src;
+  for (unsigned bid = num_consts; bid < num_nonlocals_src; ++bid) {
+    auto &old_val = non_local_block_val[bid].val;
+    if (!may_write_blk[bid]) {
+      st.non_local_block_val.emplace_back(old_val);
+      continue;
+    }
+
+    auto new_val = mkNonlocalBlockVal(BlockVal::mkFreshVar("blk_val"));
+    if (ptr_inputs) {
       expr modifies(false);
       for (auto &ptr_in : *ptr_inputs) {
-        if (!ptr_in.byval && bid < next_nonlocal_bid) {
+        if (!ptr_in.byval && !ptr_in.readonly)
           modifies |= Pointer(*this, ptr_in.val.value).getBid() == bid;
-        }
       }
-
-      auto &new_val = st.non_local_block_val[bid - num_consts];
-      auto &old_val = non_local_block_val[bid].val;
-      new_val = expr::mkIf(modifies, new_val, old_val);
+      new_val = BlockVal::mkIf(modifies, new_val, old_val);
     }
+    st.non_local_block_val.emplace_back(move(new_val));
   }
 
+  st.non_local_block_liveness = non_local_block_liveness;
   if (num_nonlocals_src && !nofree) {
-    expr one  = expr::mkUInt(1, num_nonlocals);
-    expr zero = expr::mkUInt(0, num_nonlocals);
-    expr mask = has_null_block ? one : zero;
-    for (unsigned bid = has_null_block; bid < num_nonlocals; ++bid) {
+    for (unsigned bid = has_null_block; bid < num_nonlocals_src; ++bid) {
+      auto &liveness = st.non_local_block_liveness[bid];
+      if (!may_free_blk[bid] || !nonlocal_may_be_freed(bid) ||
+          liveness.isFalse())
+        continue;
+
       expr may_free = true;
       if (ptr_inputs) {
         may_free = false;
         for (auto &ptr_in : *ptr_inputs) {
-          if (!ptr_in.byval && bid < next_nonlocal_bid)
+          if (!ptr_in.byval)
             may_free |= Pointer(*this, ptr_in.val.value).getBid() == bid;
         }
       }
       expr heap = Pointer(*this, bid, false).isHeapAllocated();
-      mask = mask | expr::mkIf(heap && may_free,
-                               zero,
-                               one << expr::mkUInt(bid, num_nonlocals));
-    }
-
-    if (mask.isAllOnes()) {
-      st.non_local_block_liveness = non_local_block_liveness;
-    } else {
-      auto liveness_var = expr::mkFreshVar("blk_liveness", mk_liveness_array());
       // functions can free an object, but cannot bring a dead one back to live
-      st.non_local_block_liveness
-        = non_local_block_liveness & (liveness_var | mask);
+      liveness = liveness && ((heap && may_free).implies(
+                                expr::mkFreshVar("blk_liveness", true)));
     }
-  } else {
-    st.non_local_block_liveness = non_local_block_liveness;
   }
   return st;
 }
@@ -1743,11 +2277,17 @@ void Memory::setState(const Memory::CallState &st) {
   auto consts = has_null_block + num_consts_src;
   for (unsigned i = consts; i < num_nonlocals_src; ++i) {
     non_local_block_val[i].val = st.non_local_block_val[i - consts];
-    if (is_initial_memblock(non_local_block_val[i].val, true))
+    if (non_local_block_val[i].val.isInitial(true))
       non_local_block_val[i].undef.clear();
   }
+  for (unsigned i = 0, e = non_local_block_liveness.size(); i != e; ++i) {
+    if (!non_local_block_liveness[i].eq(st.non_local_block_liveness[i])) {
+      state->clearDerefChecks();
+      non_local_liveness_bv = expr();
+      break;
+    }
+  }
   non_local_block_liveness = st.non_local_block_liveness;
-  mk_nonlocal_val_axioms(true);
 }
 
 static expr disjoint_local_blocks(const Memory &m, const expr &addr,
@@ -1834,14 +2374,15 @@ Memory::alloc(const expr &size, unsigned align, BlockKind blockKind,
       local_blk_addr.add(short_bid, move(blk_addr));
     }
   } else {
-    state->addAxiom(p.blockSize() == size_zext);
+    state->addAxiom(p.blockSize() == size_zext, "global-block");
     if (!has_null_block || bid != 0) {
-      state->addAxiom(p.isBlockAligned(align, true));
-      state->addAxiom(p.getAllocType() == alloc_ty);
+      state->addAxiom(p.isBlockAligned(align, true), "global-block");
+      state->addAxiom(p.getAllocType() == alloc_ty, "global-block");
     }
 
     if (align_bits && observes_addresses())
-      state->addAxiom(p.getAddress().extract(align_bits - 1, 0) == 0);
+      state->addAxiom(p.getAddress().extract(align_bits - 1, 0) == 0,
+                      "global-block");
 
     bool cond = (has_null_block && bid == 0) ||
                 (bid >= has_null_block + num_consts_src &&
@@ -1850,7 +2391,8 @@ Memory::alloc(const expr &size, unsigned align, BlockKind blockKind,
     (void)cond;
   }
 
-  store_bv(p, allocated, local_block_liveness, non_local_block_liveness);
+  store_bv(p, allocated, local_block_liveness, non_local_block_liveness,
+           non_local_liveness_bv);
   (is_local ? local_blk_size : non_local_blk_size)
     .add(short_bid, size_zext.trunc(bits_size_t - 1));
   (is_local ? local_blk_align : non_local_blk_align)
@@ -1877,7 +2419,8 @@ void Memory::startLifetime(const expr &ptr_local) {
     state->addPre(disjoint_local_blocks(*this, p.getAddress(), p.blockSize(),
                   local_blk_addr));
 
-  store_bv(p, true, local_block_liveness, non_local_block_liveness, true);
+  store_bv(p, true, local_block_liveness, non_local_block_liveness,
+           non_local_liveness_bv, true);
 }
 
 void Memory::free(const expr &ptr, bool unconstrained) {
@@ -1887,7 +2430,9 @@ void Memory::free(const expr &ptr, bool unconstrained) {
     state->addUB(p.isNull() || (p.getOffset() == 0 &&
                                 p.isBlockAlive() &&
                                 p.getAllocType() == Pointer::MALLOC));
-  store_bv(p, false, local_block_liveness, non_local_block_liveness);
+  store_bv(p, false, local_block_liveness, non_local_block_liveness,
+           non_local_liveness_bv);
+  state->clearDerefChecks();
 }
 
 unsigned Memory::getStoreByteSize(const Type &ty) {
@@ -1934,11 +2479,16 @@ void Memory::store(const StateValue &v, const Type &type, unsigned offset0,
 void Memory::store(const expr &p, const StateValue &v, const Type &type,
                    unsigned align, const set<expr> &undef_vars) {
   assert(!memory_unused());
-  Pointer ptr(*this, p);
+  expr ptr_e = p;
 
   // initializer stores are ok by construction
-  if (!state->isInitializationPhase())
-    state->addUB(ptr.isDereferenceable(getStoreByteSize(type), align, true));
+  if (!state->isInitializationPhase()) {
+    auto bytes = expr::mkUInt(getStoreByteSize(type), bits_size_t);
+    auto [trimmed, ub] = state->derefCheck(*this, p, bytes, align, true);
+    state->addUB(move(ub));
+    ptr_e = move(trimmed);
+  }
+  Pointer ptr(*this, move(ptr_e));
 
   vector<pair<unsigned, expr>> to_store;
   store(v, type, 0, to_store);
@@ -1992,7 +2542,8 @@ StateValue Memory::load(const Pointer &ptr, const Type &type, set<expr> &undef,
           }
           state->addAxiom(islocal || bid.ule(*max_bid) ||
                           (num_extra_nonconst_tgt ? bid.uge(num_nonlocals_src)
-                                                  : false));
+                                                  : false),
+                          "loaded-ptr-bid");
         }
       }
     }
@@ -2002,11 +2553,14 @@ StateValue Memory::load(const Pointer &ptr, const Type &type, set<expr> &undef,
 }
 
 pair<StateValue, AndExpr>
-Memory::load(const expr &p, const Type &type, unsigned align) {
+Memory::load(const expr &p, const Type &type, unsigned align,
+             bool guarded_ub) {
   assert(!memory_unused());
 
-  Pointer ptr(*this, p);
-  auto ubs = ptr.isDereferenceable(getStoreByteSize(type), align, false);
+  auto bytes = expr::mkUInt(getStoreByteSize(type), bits_size_t);
+  auto [ptr_e, ubs] = state->derefCheck(*this, p, bytes, align, false,
+                                        !guarded_ub);
+  Pointer ptr(*this, move(ptr_e));
   set<expr> undef_vars;
   auto ret = load(ptr, type, undef_vars, align);
   return { state->rewriteUndef(move(ret), undef_vars), move(ubs) };
@@ -2022,9 +2576,13 @@ void Memory::memset(const expr &p, const StateValue &val, const expr &bytesize,
   assert(!memory_unused());
   assert(!val.isValid() || val.bits() == 8);
   unsigned bytesz = bits_byte / 8;
-  Pointer ptr(*this, p);
-  if (deref_check)
-    state->addUB(ptr.isDereferenceable(bytesize, align, true));
+  expr ptr_e = p;
+  if (deref_check) {
+    auto [trimmed, ub] = state->derefCheck(*this, p, bytesize, align, true);
+    state->addUB(move(ub));
+    ptr_e = move(trimmed);
+  }
+  Pointer ptr(*this, move(ptr_e));
 
   auto wval = val;
   for (unsigned i = 1; i < bytesz; ++i) {
@@ -2054,9 +2612,12 @@ void Memory::memcpy(const expr &d, const expr &s, const expr &bytesize,
   assert(!memory_unused());
   unsigned bytesz = bits_byte / 8;
 
-  Pointer dst(*this, d), src(*this, s);
-  state->addUB(dst.isDereferenceable(bytesize, align_dst, true));
-  state->addUB(src.isDereferenceable(bytesize, align_src, false));
+  auto [dst_e, dst_ub] = state->derefCheck(*this, d, bytesize, align_dst, true);
+  auto [src_e, src_ub] = state->derefCheck(*this, s, bytesize, align_src,
+                                           false);
+  state->addUB(move(dst_ub));
+  state->addUB(move(src_ub));
+  Pointer dst(*this, move(dst_e)), src(*this, move(src_e));
   if (!is_move)
     src.isDisjointOrEqual(bytesize, dst, bytesize);
 
@@ -2101,8 +2662,7 @@ void Memory::copy(const Pointer &src, const Pointer &dst) {
   dst_blk.undef.clear();
   dst_blk.type = DATA_NONE;
 
-  auto offset = expr::mkUInt(0, Pointer::bitsShortOffset());
-  DisjointExpr val(expr::mkConstArray(offset, Byte::mkPoisonByte(*this)()));
+  DisjointExpr val(BlockVal::mkConst(Byte::mkPoisonByte(*this)()));
 
   auto fn = [&](MemBlock &blk, unsigned bid, bool local, expr &&cond) {
     // we assume src != dst
@@ -2118,6 +2678,7 @@ void Memory::copy(const Pointer &src, const Pointer &dst) {
 
 expr Memory::ptr2int(const expr &ptr) const {
   assert(!memory_unused());
+  usePtrInputs(ptr);
   return Pointer(*this, ptr).getAddress();
 }
 
@@ -2136,8 +2697,8 @@ expr Memory::blockValRefined(const Memory &other, unsigned bid, bool local,
   if (mem1.val.eq(mem2))
     return true;
 
-  int is_fn1 = is_initial_memblock(mem1.val, true);
-  int is_fn2 = is_initial_memblock(mem2, true);
+  int is_fn1 = mem1.val.isInitial(true);
+  int is_fn2 = mem2.isInitial(true);
   if (is_fn1 && is_fn2) {
     // if both memories are the result of a function call, then refinement
     // holds iif they are equal, otherwise we can always force a behavior
@@ -2166,7 +2727,11 @@ expr Memory::blockValRefined(const Memory &other, unsigned bid, bool local,
   expr np2 = val2.nonptrNonpoison();
 
   expr int_cnstr;
-  if (bits_poison_per_byte == bits_byte) {
+  // with the SoA layout, the fields can be compared independently
+  if (mem1.val.eqNonPtrFields(mem2)) {
+    int_cnstr = true;
+  }
+  else if (bits_poison_per_byte == bits_byte) {
     int_cnstr = (np2 | np1) == np1 && (v1 | np1) == (v2 | np1);
   }
   else if (bits_poison_per_byte > 1) {
@@ -2190,7 +2755,9 @@ expr Memory::blockValRefined(const Memory &other, unsigned bid, bool local,
   expr is_ptr = val.isPtr();
   expr is_ptr2 = val2.isPtr();
   expr ptr_cnstr;
-  if (!does_ptr_store || is_ptr.isFalse() || is_ptr2.isFalse()) {
+  if (mem1.val.eqPtrFields(mem2)) {
+    ptr_cnstr = true;
+  } else if (!does_ptr_store || is_ptr.isFalse() || is_ptr2.isFalse()) {
     ptr_cnstr = val == val2;
   } else {
     ptr_cnstr = !val.ptrNonpoison() ||
@@ -2311,6 +2878,8 @@ expr Memory::checkNocapture() const {
 }
 
 void Memory::escapeLocalPtr(const expr &ptr) {
+  usePtrInputs(ptr);
+
   if (next_local_bid == 0)
     return;
 
@@ -2337,21 +2906,28 @@ Memory Memory::mkIf(const expr &cond, const Memory &then, const Memory &els) {
        bid < end; ++bid) {
     auto &other = els.non_local_block_val[bid];
     ret.non_local_block_val[bid].val
-      = expr::mkIf(cond, then.non_local_block_val[bid].val, other.val);
+      = BlockVal::mkIf(cond, then.non_local_block_val[bid].val, other.val);
     ret.non_local_block_val[bid].undef.insert(other.undef.begin(),
                                               other.undef.end());
   }
   for (unsigned bid = 0, end = ret.numLocals(); bid < end; ++bid) {
     auto &other = els.local_block_val[bid];
     ret.local_block_val[bid].val
-      = expr::mkIf(cond, then.local_block_val[bid].val, other.val);
+      = BlockVal::mkIf(cond, then.local_block_val[bid].val, other.val);
     ret.local_block_val[bid].undef.insert(other.undef.begin(),
                                           other.undef.end());
   }
-  ret.non_local_block_liveness = expr::mkIf(cond, then.non_local_block_liveness,
-                                            els.non_local_block_liveness);
-  ret.local_block_liveness     = expr::mkIf(cond, then.local_block_liveness,
-                                            els.local_block_liveness);
+  for (unsigned bid = 0, end = ret.non_local_block_liveness.size(); bid < end;
+       ++bid) {
+    auto &other = els.non_local_block_liveness[bid];
+    if (!other.eq(then.non_local_block_liveness[bid])) {
+      ret.non_local_block_liveness[bid]
+        = expr::mkIf(cond, then.non_local_block_liveness[bid], other);
+      ret.non_local_liveness_bv = expr();
+    }
+  }
+  ret.local_block_liveness = expr::mkIf(cond, then.local_block_liveness,
+                                        els.local_block_liveness);
   ret.local_blk_addr.add(els.local_blk_addr);
   ret.local_blk_size.add(els.local_blk_size);
   ret.local_blk_align.add(els.local_blk_align);
@@ -2480,13 +3056,25 @@ ostream& operator<<(ostream &os, const Memory &m) {
     return os;
   os << "\n\nMEMORY\n======\n"
         "BLOCK VALUE:";
-  for (unsigned i = 0; i < m.numLocals(); ++i)
-    os << "\nLocal BLK " << i << ":\t" << m.local_block_val[i].val.simplify();
-  for (unsigned i = 0; i < m.numNonlocals(); ++i)
-    os << "\nNonLocal BLK " << i << ":\t"
-       << m.non_local_block_val[i].val.simplify();
+  for (unsigned i = 0; i < m.numLocals(); ++i) {
+    os << "\nLocal BLK " << i << ":\t";
+    m.local_block_val[i].val.simplify().print(os);
+  }
+  for (unsigned i = 0; i < m.numNonlocals(); ++i) {
+    os << "\nNonLocal BLK " << i << ":\t";
+    m.non_local_block_val[i].val.simplify().print(os);
+  }
   os << '\n';
-  P("BLOCK LIVENESS:", local_block_liveness, non_local_block_liveness);
+  os << "BLOCK LIVENESS:\n";
+  if (m.numLocals() > 0)
+    os << "Local: " << m.local_block_liveness.simplify() << '\n';
+  if (m.numNonlocals() > 0) {
+    os << "Non-local:";
+    for (auto &l : m.non_local_block_liveness) {
+      os << ' ' << l.simplify();
+    }
+    os << "\n\n";
+  }
   P("BLOCK SIZE:", local_blk_size, non_local_blk_size);
   P("BLOCK ALIGN:", local_blk_align, non_local_blk_align);
   P("BLOCK KIND:", local_blk_kind, non_local_blk_kind);
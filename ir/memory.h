@@ -8,6 +8,8 @@
 #include "ir/type.h"
 #include "smt/expr.h"
 #include "smt/exprs.h"
+#include <array>
+#include <functional>
 #include <map>
 #include <optional>
 #include <ostream>
@@ -97,7 +99,26 @@ class Pointer {
   // readonly argument. If block is local, is-readonly or is-nocapture cannot
   // be 1.
   // TODO: missing support for address space
-  smt::expr p;
+  //
+  // The fields are kept unpacked, such that accessing them doesn't require
+  // an extract and pointer arithmetic doesn't rebuild the whole bitvector.
+  // Either representation is computed from the other on demand and cached:
+  // fields are extracted from a packed pointer only when accessed, and the
+  // packed bitvector is only built when needed (e.g., when the pointer is
+  // stored to memory).
+  mutable smt::expr bid;    // including the local bit
+  mutable smt::expr offset;
+  mutable smt::expr attrs;  // invalid if there are no attributes
+  mutable smt::expr p;
+
+  const smt::expr& bidField() const;
+  const smt::expr& offsetField() const;
+  const smt::expr& attrsField() const;
+  // extracts bits [high, low] of the packed representation, using the given
+  // field (whose lowest bit is at field_low) if available
+  smt::expr extract(const smt::expr &field, unsigned field_low, unsigned high,
+                    unsigned low) const;
+  void unpack(smt::expr &&repr);
 
   smt::expr getValue(const char *name, const smt::FunctionExpr &local_fn,
                       const smt::FunctionExpr &nonlocal_fn,
@@ -129,13 +150,13 @@ public:
 
   smt::expr blockSize() const;
 
-  const smt::expr& operator()() const { return p; }
+  const smt::expr& operator()() const;
   // Returns expr with short_bid+offset. It strips attrs away.
   // If this pointer is constructed with var_name (has_attr with false),
   // the returned expr is the variable.
   smt::expr shortPtr() const;
-  smt::expr release() { return std::move(p); }
-  unsigned bits() const { return p.bits(); }
+  smt::expr release();
+  unsigned bits() const { return totalBits(); }
 
   Pointer operator+(unsigned) const;
   Pointer operator+(const smt::expr &bytes) const;
@@ -233,14 +254,66 @@ class Memory {
   enum DataType { DATA_NONE = 0, DATA_INT = 1, DATA_PTR = 2,
                   DATA_ANY = DATA_INT | DATA_PTR };
 
+  // Contents of a memory block: short offset -> Byte.
+  // With the packed layout, this is a single array of Bytes. With the SoA
+  // layout (config::memory_soa), the data bytes, their non-poison bits and
+  // the pointer provenance are kept in separate arrays, such that stores
+  // of plain data leave the poison and provenance arrays untouched.
+  class BlockVal {
+    // packed: { array of Bytes }
+    // SoA: { data bytes, non-poison bits, pointer fields }
+    std::array<smt::expr, 3> arrays;
+    // 1 if initial memory, 2 if the result of a function call, 0 otherwise
+    unsigned char initial = 0;
+
+    BlockVal(std::array<smt::expr, 3> &&arrays, unsigned char initial = 0)
+      : arrays(std::move(arrays)), initial(initial) {}
+
+  public:
+    BlockVal() {}
+    static BlockVal mkConst(const smt::expr &byte);
+    // block whose first bytes.size() bytes are the given ones
+    static BlockVal mkConst(const std::vector<smt::expr> &bytes);
+    static BlockVal mkArray(const char *name);
+    static BlockVal mkFreshVar(const char *name);
+    // lambda offset. cond ? byte : els[offset]
+    static BlockVal mkLambda(const smt::expr &offset, const smt::expr &cond,
+                             const smt::expr &byte, const BlockVal &els);
+    static BlockVal mkIf(const smt::expr &cond, const BlockVal &then,
+                         const BlockVal &els);
+
+    // lambda offset. this[offset], with fn applied to the pointer value if
+    // the byte is a pointer
+    BlockVal mapPtrs(
+      const std::function<smt::expr(const smt::expr&)> &fn) const;
+
+    smt::expr load(const smt::expr &offset) const;
+    BlockVal store(const smt::expr &offset, const smt::expr &byte) const;
+
+    // 1 if initial memory, 2 if the result of a function call, 0 otherwise
+    int isInitial(bool match_any_init = false) const;
+    // the pointer (resp. non-pointer) fields of all bytes are equal; the
+    // pointer fields include the poison bits, as these are shared
+    bool eqPtrFields(const BlockVal &rhs) const;
+    bool eqNonPtrFields(const BlockVal &rhs) const;
+
+    smt::expr operator==(const BlockVal &rhs) const;
+    bool eq(const BlockVal &rhs) const;
+    BlockVal simplify() const;
+
+    // for container use only
+    bool operator<(const BlockVal &rhs) const;
+    void print(std::ostream &os) const;
+  };
+
   struct MemBlock {
-    smt::expr val; // array: short offset -> Byte
+    BlockVal val;
     std::set<smt::expr> undef;
     unsigned char type = DATA_ANY;
 
     MemBlock() {}
-    MemBlock(smt::expr &&val) : val(std::move(val)) {}
-    MemBlock(smt::expr &&val, DataType type)
+    MemBlock(BlockVal &&val) : val(std::move(val)) {}
+    MemBlock(BlockVal &&val, DataType type)
       : val(std::move(val)), type(type) {}
 
     bool operator<(const MemBlock &other) const {
@@ -252,8 +325,13 @@ class Memory {
   std::vector<MemBlock> non_local_block_val;
   std::vector<MemBlock> local_block_val;
 
-  smt::expr non_local_block_liveness; // BV w/ 1 bit per bid (1 if live)
-  smt::expr local_block_liveness;
+  // bid -> bool (true if live). Blocks that cannot be freed, like globals,
+  // are constant.
+  std::vector<smt::expr> non_local_block_liveness;
+  // the above as a BV w/ 1 bit per bid, for lookups with a symbolic bid.
+  // Built on demand; reset whenever non_local_block_liveness changes.
+  mutable smt::expr non_local_liveness_bv;
+  smt::expr local_block_liveness; // BV w/ 1 bit per bid (1 if live)
 
   smt::FunctionExpr local_blk_addr; // bid -> (bits_size_t - 1)
   smt::FunctionExpr local_blk_size;
@@ -274,7 +352,8 @@ class Memory {
   unsigned numLocals() const;
   unsigned numNonlocals() const;
 
-  void mk_nonlocal_val_axioms(bool skip_consts);
+  void mk_nonlocal_val_axioms();
+  BlockVal mkNonlocalBlockVal(BlockVal &&val) const;
 
   bool mayalias(bool local, unsigned bid, const smt::expr &offset,
                 unsigned bytes, unsigned align, bool write) const;
@@ -316,8 +395,8 @@ public:
 
   // TODO: missing local_* equivalents
   class CallState {
-    std::vector<smt::expr> non_local_block_val;
-    smt::expr non_local_block_liveness;
+    std::vector<BlockVal> non_local_block_val;
+    std::vector<smt::expr> non_local_block_liveness;
 
   public:
     static CallState mkIf(const smt::expr &cond, const CallState &then,
@@ -336,18 +415,22 @@ public:
 
   void markByVal(unsigned bid);
   smt::expr mkInput(const char *name, const ParamAttrs &attrs);
+  // Adds the deferred axioms of the pointer inputs that ptr may be based on
+  void usePtrInputs(const smt::expr &ptr) const;
   std::pair<smt::expr, smt::expr> mkUndefInput(const ParamAttrs &attrs) const;
 
   struct PtrInput {
     StateValue val;
     bool byval;
     bool nocapture;
+    bool readonly; // the callee doesn't write through this pointer
 
-    PtrInput(StateValue &&v, bool byval, bool nocapture) :
-      val(std::move(v)), byval(byval), nocapture(nocapture) {}
+    PtrInput(StateValue &&v, bool byval, bool nocapture, bool readonly) :
+      val(std::move(v)), byval(byval), nocapture(nocapture),
+      readonly(readonly) {}
     bool operator<(const PtrInput &rhs) const {
-      return std::tie(val, byval, nocapture) <
-             std::tie(rhs.val, rhs.byval, rhs.nocapture);
+      return std::tie(val, byval, nocapture, readonly) <
+             std::tie(rhs.val, rhs.byval, rhs.nocapture, rhs.readonly);
     }
   };
 
@@ -378,8 +461,11 @@ public:
   static unsigned getStoreByteSize(const Type &ty);
   void store(const smt::expr &ptr, const StateValue &val, const Type &type,
              unsigned align, const std::set<smt::expr> &undef_vars);
+  // Returns the loaded value and the UB of the access. Set guarded_ub if the
+  // UB is not added unconditionally to the current path.
   std::pair<StateValue, smt::AndExpr>
-    load(const smt::expr &ptr, const Type &type, unsigned align);
+    load(const smt::expr &ptr, const Type &type, unsigned align,
+         bool guarded_ub = false);
 
   // raw load
   Byte load(const Pointer &p, std::set<smt::expr> &undef_vars, unsigned align);
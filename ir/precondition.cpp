@@ -12,8 +12,67 @@ using namespace smt;
 using namespace std;
 using namespace util;
 
+// Constant inputs of up to this many bits in total are enumerated when
+// deciding a predicate
+static constexpr unsigned max_enum_bits = 8;
+
+static optional<bool> eval_const(const expr &e) {
+  auto decide = [](expr &&e) -> optional<bool> {
+    if (!e.isConst())
+      e = e.simplify();
+    if (e.isTrue())
+      return true;
+    if (e.isFalse())
+      return false;
+    return {};
+  };
+
+  if (auto r = decide(expr(e)))
+    return r;
+
+  vector<expr> vars;
+  unsigned bits = 0;
+  for (auto &v : e.vars()) {
+    if (!v.isBV())
+      return {};
+    bits += v.bits();
+    if (bits > max_enum_bits)
+      return {};
+    vars.emplace_back(v);
+  }
+
+  optional<bool> ret;
+  vector<pair<expr, expr>> repls;
+  for (uint64_t n = 0; n < (UINT64_C(1) << bits); ++n) {
+    repls.clear();
+    unsigned shift = 0;
+    for (auto &v : vars) {
+      auto vbits = v.bits();
+      repls.emplace_back(v, expr::mkUInt((n >> shift) & ((1u << vbits) - 1),
+                                         vbits));
+      shift += vbits;
+    }
+    auto r = decide(e.subst(repls));
+    if (!r || (ret && *ret != *r))
+      return {};
+    ret = r;
+  }
+  return ret;
+}
+
 namespace IR {
 
+expr Predicate::getConstExpr() const {
+  return {};
+}
+
+optional<bool> Predicate::eval() const {
+  auto e = getConstExpr();
+  if (!e.isValid())
+    return {};
+  return eval_const(e);
+}
+
 expr Predicate::getTypeConstraints() const {
   return true;
 }
@@ -41,6 +100,51 @@ expr BoolPred::toSMT(State &s) const {
   UNREACHABLE();
 }
 
+expr BoolPred::getConstExpr() const {
+  auto a = lhs.getConstExpr();
+  auto b = rhs.getConstExpr();
+  if (!a.isValid() || !b.isValid())
+    return {};
+  switch (pred) {
+  case AND: return a && b;
+  case OR:  return a || b;
+  }
+  UNREACHABLE();
+}
+
+optional<bool> BoolPred::eval() const {
+  if (auto r = Predicate::eval())
+    return r;
+
+  // the operands may still be decided individually
+  auto a = lhs.eval();
+  auto b = rhs.eval();
+  switch (pred) {
+  case AND:
+    if ((a && !*a) || (b && !*b))
+      return false;
+    if (a && b)
+      return true;
+    return {};
+  case OR:
+    if ((a && *a) || (b && *b))
+      return true;
+    if (a && b)
+      return false;
+    return {};
+  }
+  UNREACHABLE();
+}
+
+expr BoolPred::getTypeConstraints() const {
+  return lhs.getTypeConstraints() && rhs.getTypeConstraints();
+}
+
+void BoolPred::fixupTypes(const Model &m) {
+  lhs.fixupTypes(m);
+  rhs.fixupTypes(m);
+}
+
 
 // name, num_args
 static pair<const char*,unsigned> fn_data[] = {
@@ -105,6 +209,20 @@ expr FnPred::mkMustAnalysis(State &s, expr &&e) const {
   return var;
 }
 
+expr FnPred::mkCheck(const expr &a, const expr &b) const {
+  switch (fn) {
+  case AddNSW: return a.add_no_soverflow(b);
+  case AddNUW: return a.add_no_uoverflow(b);
+  case SubNSW: return a.sub_no_soverflow(b);
+  case SubNUW: return a.sub_no_uoverflow(b);
+  case MulNSW: return a.mul_no_soverflow(b);
+  case MulNUW: return a.mul_no_uoverflow(b);
+  case ShlNSW: return a.shl_no_soverflow(b);
+  case ShlNUW: return a.shl_no_uoverflow(b);
+  }
+  UNREACHABLE();
+}
+
 expr FnPred::toSMT(State &s) const {
   vector<StateValue> vals;
   for (auto a : args) {
@@ -115,34 +233,20 @@ expr FnPred::toSMT(State &s) const {
   for (auto &v : vals) {
     r &= v.non_poison;
   }
+  return r && mkMustAnalysis(s, mkCheck(vals[0].value, vals[1].value));
+}
 
-  switch (fn) {
-  case AddNSW:
-    r &= mkMustAnalysis(s, vals[0].value.add_no_soverflow(vals[1].value));
-    break;
-  case AddNUW:
-    r &= mkMustAnalysis(s, vals[0].value.add_no_uoverflow(vals[1].value));
-    break;
-  case SubNSW:
-    r &= mkMustAnalysis(s, vals[0].value.sub_no_soverflow(vals[1].value));
-    break;
-  case SubNUW:
-    r &= mkMustAnalysis(s, vals[0].value.sub_no_uoverflow(vals[1].value));
-    break;
-  case MulNSW:
-    r &= mkMustAnalysis(s, vals[0].value.mul_no_soverflow(vals[1].value));
-    break;
-  case MulNUW:
-    r &= mkMustAnalysis(s, vals[0].value.mul_no_uoverflow(vals[1].value));
-    break;
-  case ShlNSW:
-    r &= mkMustAnalysis(s, vals[0].value.shl_no_soverflow(vals[1].value));
-    break;
-  case ShlNUW:
-    r &= mkMustAnalysis(s, vals[0].value.shl_no_uoverflow(vals[1].value));
-    break;
+expr FnPred::getConstExpr() const {
+  vector<expr> vals;
+  for (auto a : args) {
+    auto c = dynamic_cast<const Constant*>(a);
+    if (!c)
+      return {};
+    vals.emplace_back(c->getConstValue());
+    if (!vals.back().isValid())
+      return {};
   }
-  return r;
+  return mkCheck(vals[0], vals[1]);
 }
 
 expr FnPred::getTypeConstraints() const {
@@ -191,23 +295,34 @@ void CmpPred::print(ostream &os) const {
   rhs.print(os << p);
 }
 
+expr CmpPred::mkCmp(const expr &a, const expr &b) const {
+  switch (pred) {
+  case EQ:  return a == b;
+  case NE:  return a != b;
+  case SLE: return a.sle(b);
+  case SLT: return a.slt(b);
+  case SGE: return a.sge(b);
+  case SGT: return a.sgt(b);
+  case ULE: return a.ule(b);
+  case ULT: return a.ult(b);
+  case UGE: return a.uge(b);
+  case UGT: return a.ugt(b);
+  }
+  UNREACHABLE();
+}
+
 expr CmpPred::toSMT(State &s) const {
   auto &[a, ap] = s[lhs];
   auto &[b, bp] = s[rhs];
-  expr r;
-  switch (pred) {
-  case EQ:  r = a == b; break;
-  case NE:  r = a != b; break;
-  case SLE: r = a.sle(b); break;
-  case SLT: r = a.slt(b); break;
-  case SGE: r = a.sge(b); break;
-  case SGT: r = a.sgt(b); break;
-  case ULE: r = a.ule(b); break;
-  case ULT: r = a.ult(b); break;
-  case UGE: r = a.uge(b); break;
-  case UGT: r = a.ugt(b); break;
-  }
-  return { ap && bp && move(r) };
+  return { ap && bp && mkCmp(a, b) };
+}
+
+expr CmpPred::getConstExpr() const {
+  auto a = lhs.getConstValue();
+  auto b = rhs.getConstValue();
+  if (!a.isValid() || !b.isValid())
+    return {};
+  return mkCmp(a, b);
 }
 
 expr CmpPred::getTypeConstraints() const {
@@ -5,6 +5,7 @@
 
 #include "ir/constant.h"
 #include "ir/value.h"
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -17,6 +18,13 @@ class Predicate {
 public:
   virtual void print(std::ostream &os) const = 0;
   virtual smt::expr toSMT(State &s) const = 0;
+  // Returns the predicate under the current typing as a function of the
+  // constant inputs, or an invalid expression if it needs a State.
+  virtual smt::expr getConstExpr() const;
+  // Decides the predicate for the current typing without the SMT solver,
+  // enumerating the values of narrow constant inputs. Returns nothing if it
+  // can't be decided this way.
+  virtual std::optional<bool> eval() const;
   virtual smt::expr getTypeConstraints() const;
   virtual void fixupTypes(const smt::Model &m);
   virtual ~Predicate() {}
@@ -36,6 +44,10 @@ public:
     : lhs(lhs), rhs(rhs), pred(pred) {}
   void print(std::ostream &os) const override;
   smt::expr toSMT(State &s) const override;
+  smt::expr getConstExpr() const override;
+  std::optional<bool> eval() const override;
+  smt::expr getTypeConstraints() const override;
+  void fixupTypes(const smt::Model &m) override;
 };
 
 
@@ -44,11 +56,13 @@ class FnPred final : public Predicate {
   std::vector<Value*> args;
 
   smt::expr mkMustAnalysis(State &s, smt::expr &&e) const;
+  smt::expr mkCheck(const smt::expr &a, const smt::expr &b) const;
 
 public:
   FnPred(std::string_view name, std::vector<Value*> &&args);
   void print(std::ostream &os) const override;
   smt::expr toSMT(State &s) const override;
+  smt::expr getConstExpr() const override;
   smt::expr getTypeConstraints() const override;
   void fixupTypes(const smt::Model &m) override;
 };
@@ -67,12 +81,15 @@ private:
   Constant &lhs, &rhs;
   Pred pred;
 
+  smt::expr mkCmp(const smt::expr &a, const smt::expr &b) const;
+
 public:
   CmpPred(Constant &lhs, Constant &rhs, Pred pred)
     : lhs(lhs), rhs(rhs), pred(pred) {}
 
   void print(std::ostream &os) const override;
   smt::expr toSMT(State &s) const override;
+  smt::expr getConstExpr() const override;
   smt::expr getTypeConstraints() const override;
   void fixupTypes(const smt::Model &m) override;
 };
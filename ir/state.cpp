@@ -5,6 +5,7 @@
 #include "ir/function.h"
 #include "ir/globals.h"
 #include "smt/smt.h"
+#include "util/config.h"
 #include "util/errors.h"
 #include <cassert>
 
@@ -56,6 +57,19 @@ void State::ValueAnalysis::intersect(const State::ValueAnalysis &other) {
     if (!other.ranges_fn_calls.count(fn))
       interval.first = 0;
   }
+
+  for (auto I = deref_checks.begin(); I != deref_checks.end(); ) {
+    auto OI = other.deref_checks.find(I->first);
+    if (OI == other.deref_checks.end() || !I->second.ptr.eq(OI->second.ptr)) {
+      I = deref_checks.erase(I);
+      continue;
+    }
+    auto &check = I->second;
+    check.bytes       = min(check.bytes, OI->second.bytes);
+    check.bytes_write = min(check.bytes_write, OI->second.bytes_write);
+    check.align       = min(check.align, OI->second.align);
+    ++I;
+  }
 }
 
 bool
@@ -496,6 +510,34 @@ void State::addReturn(StateValue &&val) {
   addUB(expr(false));
 }
 
+void State::addAxiom(AndExpr &&ands, const char *kind) {
+  if (config::axiom_stats)
+    axioms_by_kind[kind].add(ands);
+  axioms.add(move(ands));
+}
+
+void State::addAxiom(expr &&axiom, const char *kind) {
+  if (config::axiom_stats)
+    axioms_by_kind[kind].add(axiom);
+  axioms.add(move(axiom));
+}
+
+void State::addPtrInputAxiom(const expr &bid, AndExpr &&ands,
+                             const char *kind) {
+  ptr_input_axioms[bid].emplace_back(move(ands), kind);
+}
+
+void State::usePtrInput(const expr &bid) {
+  auto I = ptr_input_axioms.find(bid);
+  if (I == ptr_input_axioms.end())
+    return;
+
+  for (auto &[ands, kind] : I->second) {
+    addAxiom(move(ands), kind);
+  }
+  ptr_input_axioms.erase(I);
+}
+
 void State::addUB(expr &&ub) {
   bool isconst = ub.isConst();
   domain.UB.add(move(ub));
@@ -516,6 +558,38 @@ void State::addUB(AndExpr &&ubs) {
     domain.undef_vars.insert(undef_vars.begin(), undef_vars.end());
 }
 
+pair<expr, AndExpr>
+State::derefCheck(const Memory &m, const expr &ptr, const expr &bytes,
+                  unsigned align, bool iswrite, bool record) {
+  // Checks are only reused for constant sizes. A check of the same pointer
+  // with at least as many bytes (and writable if needed) and at least the
+  // same alignment implies this one, as long as no block was freed since.
+  uint64_t n;
+  bool cacheable = bytes.isUInt(n) && n != 0;
+  if (cacheable) {
+    auto I = analysis.deref_checks.find(ptr);
+    if (I != analysis.deref_checks.end()) {
+      auto &check = I->second;
+      if ((iswrite ? check.bytes_write : check.bytes) >= n &&
+          check.align >= align)
+        return { check.ptr, AndExpr() };
+    }
+  }
+
+  Pointer p(m, ptr);
+  auto ub = p.isDereferenceable(bytes, align, iswrite);
+
+  if (cacheable && record) {
+    auto &check = analysis.deref_checks[ptr];
+    check.bytes = max(check.bytes, n);
+    if (iswrite)
+      check.bytes_write = max(check.bytes_write, n);
+    check.align = max(check.align, align);
+    check.ptr   = p();
+  }
+  return { p.release(), move(ub) };
+}
+
 void State::addNoReturn() {
   return_memory.add(memory, domain.path);
   function_domain.add(domain());
@@ -549,8 +623,11 @@ expr State::FnCallInput::refinedBy(
   for (unsigned i = 0, e = args_ptr.size(); i != e; ++i) {
     // TODO: needs to take read/read2 as input to control if mem blocks
     // need to be compared
-    auto &[ptr_in, is_byval, is_nocapture] = args_ptr[i];
-    auto &[ptr_in2, is_byval2, is_nocapture2] = args_ptr2[i];
+    // readonly is a property of the callee, so it can differ
+    auto &[ptr_in, is_byval, is_nocapture, is_readonly] = args_ptr[i];
+    auto &[ptr_in2, is_byval2, is_nocapture2, is_readonly2] = args_ptr2[i];
+    (void)is_readonly;
+    (void)is_readonly2;
     if (is_byval != is_byval2 || is_nocapture != is_nocapture2)
       return false;
 
@@ -617,8 +694,12 @@ State::addFnCall(const string &name, vector<StateValue> &&inputs,
                  const vector<Type*> &out_types, const FnAttrs &attrs) {
   // TODO: can read/write=false fn calls be removed?
 
-  bool reads_memory = !attrs.has(FnAttrs::NoRead);
-  bool writes_memory = !attrs.has(FnAttrs::NoWrite);
+  // memory not accessible from this module isn't modeled
+  bool inaccessiblememonly = attrs.has(FnAttrs::InaccessibleMemOnly);
+  bool reads_memory = !attrs.has(FnAttrs::NoRead) && !inaccessiblememonly;
+  bool writes_memory = !attrs.has(FnAttrs::NoWrite) && !inaccessiblememonly;
+  // inaccessiblememonly fns may still change their hidden state on each call
+  bool has_side_effects = !attrs.has(FnAttrs::NoWrite);
   bool argmemonly = attrs.has(FnAttrs::ArgMemOnly);
   bool noundef = attrs.has(FnAttrs::NoUndef);
 
@@ -710,7 +791,7 @@ State::addFnCall(const string &name, vector<StateValue> &&inputs,
     }
   }
 
-  if (writes_memory) {
+  if (has_side_effects) {
     auto [I, inserted] = analysis.ranges_fn_calls.try_emplace(name, 1, 1);
     if (!inserted) {
       ++I->second.first;
@@ -729,6 +810,14 @@ void State::addQuantVar(const expr &var) {
   quantified_vars.emplace(var);
 }
 
+void State::addFreezeVar(const expr &var, const Value &val, unsigned idx) {
+  freeze_vars.try_emplace(var, &val, idx);
+}
+
+void State::addNaNVar(const expr &var) {
+  nan_vars.emplace_back(var);
+}
+
 void State::addFnQuantVar(const expr &var) {
   fn_call_qvars.emplace(var);
 }
@@ -761,6 +850,13 @@ void State::finishInitializer() {
   is_initialization_phase = false;
 }
 
+void State::finishExecution() {
+  return_domain_joined = return_domain();
+  function_domain_joined = function_domain();
+  return_val_joined = *return_val();
+  return_memory_joined.emplace(*return_memory());
+}
+
 expr State::sinkDomain() const {
   auto bb = f.getBBIfExists("#sink");
   if (!bb)
@@ -9,6 +9,7 @@
 #include "smt/exprs.h"
 #include <array>
 #include <map>
+#include <optional>
 #include <ostream>
 #include <set>
 #include <string>
@@ -27,6 +28,9 @@ class Function;
 class State {
 public:
   using ValTy = std::pair<StateValue, std::set<smt::expr>>;
+  // (base ptr, block size if inbounds, inbounds, (obj size, idx) prefix)
+  using GEPKey = std::tuple<smt::expr, smt::expr, bool,
+                            std::vector<std::pair<unsigned, StateValue>>>;
 
 private:
   struct CurrentDomain {
@@ -58,6 +62,15 @@ private:
     };
     FnCallRanges ranges_fn_calls;
 
+    // dereferenceability checks whose UB was added to the path
+    struct DerefCheck {
+      uint64_t bytes = 0;
+      uint64_t bytes_write = 0;
+      unsigned align = 1;
+      smt::expr ptr; // the pointer as trimmed by the check
+    };
+    std::map<smt::expr, DerefCheck> deref_checks; // ptr -> check
+
     void intersect(const ValueAnalysis &other);
   };
 
@@ -74,11 +87,21 @@ private:
   bool is_initialization_phase = true;
   smt::AndExpr precondition;
   smt::AndExpr axioms;
+  // kind -> axioms; only filled with config::axiom_stats
+  std::map<std::string, smt::AndExpr> axioms_by_kind;
+  // bid of pointer input -> (axioms, kind); only added once the pointer is
+  // used by a memory operation or comparison
+  std::map<smt::expr, std::vector<std::pair<smt::AndExpr, const char*>>>
+    ptr_input_axioms;
 
   std::set<const char*> used_unsupported;
 
   const BasicBlock *current_bb = nullptr;
   std::set<smt::expr> quantified_vars;
+  // nondet var of freeze -> (freeze, element index)
+  std::map<smt::expr, std::pair<const Value*, unsigned>> freeze_vars;
+  // NaN payloads of float to int conversions, in order of creation
+  std::vector<smt::expr> nan_vars;
 
   // var -> ((value, not_poison), undef_vars, already_used?)
   std::unordered_map<const Value*, unsigned> values_map;
@@ -109,6 +132,11 @@ private:
   smt::DisjointExpr<Memory> return_memory;
   std::set<smt::expr> return_undef_vars;
 
+  // joins of the above, computed once by finishExecution()
+  smt::expr return_domain_joined, function_domain_joined;
+  StateValue return_val_joined;
+  std::optional<Memory> return_memory_joined;
+
   struct FnCallInput {
     std::vector<StateValue> args_nonptr;
     std::vector<Memory::PtrInput> args_ptr;
@@ -137,6 +165,10 @@ private:
   smt::expr fn_call_pre = true;
   std::set<smt::expr> fn_call_qvars;
 
+  // GEP encodings are shared by GEPs with a common prefix of indices.
+  // The block size is part of the key as it's path dependent.
+  std::map<GEPKey, std::pair<Pointer, smt::AndExpr>> gep_cache;
+
 public:
   State(Function &f, bool source);
 
@@ -164,14 +196,29 @@ public:
   void addReturn(StateValue &&val);
 
   /*--- Axioms, preconditions, domains ---*/
-  void addAxiom(smt::AndExpr &&ands) { axioms.add(std::move(ands)); }
-  void addAxiom(smt::expr &&axiom) { axioms.add(std::move(axiom)); }
+  // kind is a short name of the family of the axiom, for statistics
+  void addAxiom(smt::AndExpr &&ands, const char *kind);
+  void addAxiom(smt::expr &&axiom, const char *kind);
+  void addPtrInputAxiom(const smt::expr &bid, smt::AndExpr &&ands,
+                        const char *kind);
+  void usePtrInput(const smt::expr &bid);
+  bool hasPtrInputAxioms() const { return !ptr_input_axioms.empty(); }
   void addPre(smt::expr &&cond) { precondition.add(std::move(cond)); }
   void addUB(smt::expr &&ub);
   void addUB(const smt::expr &ub);
   void addUB(smt::AndExpr &&ubs);
   void addNoReturn();
 
+  // Returns the UB of dereferencing ptr in m and the pointer trimmed to the
+  // blocks it may dereference. The UB is empty if a check already done in
+  // the current path implies this one. If record is true, the caller must
+  // add the UB to the path unconditionally, and later checks may rely on it.
+  std::pair<smt::expr, smt::AndExpr>
+    derefCheck(const Memory &m, const smt::expr &ptr, const smt::expr &bytes,
+               unsigned align, bool iswrite, bool record = true);
+  // to be called when blocks may have been freed
+  void clearDerefChecks() { analysis.deref_checks.clear(); }
+
   std::vector<StateValue>
     addFnCall(const std::string &name, std::vector<StateValue> &&inputs,
               std::vector<Memory::PtrInput> &&ptr_inputs,
@@ -181,6 +228,8 @@ public:
   auto& getUnsupported() const { return used_unsupported; }
 
   void addQuantVar(const smt::expr &var);
+  void addFreezeVar(const smt::expr &var, const Value &val, unsigned idx);
+  void addNaNVar(const smt::expr &var);
   void addFnQuantVar(const smt::expr &var);
   void addUndefVar(smt::expr &&var);
   auto& getUndefVars() const { return undef_vars; }
@@ -194,20 +243,29 @@ public:
 
   auto& getFn() const { return f; }
   auto& getMemory() { return memory; }
+  auto& getGEPCache() { return gep_cache; }
   auto& getAxioms() const { return axioms; }
+  auto& getAxiomsByKind() const { return axioms_by_kind; }
   auto& getPre() const { return precondition; }
   auto& getFnPre() const { return fn_call_pre; }
   const auto& getValues() const { return values; }
   const auto& getQuantVars() const { return quantified_vars; }
+  const auto& getFreezeVars() const { return freeze_vars; }
+  const auto& getNaNVars() const { return nan_vars; }
   const auto& getFnQuantVars() const { return fn_call_qvars; }
 
-  auto& functionDomain() const { return function_domain; }
-  auto& returnDomain() const { return return_domain; }
+  // Joins the return values, memories and domains of all return sites.
+  // Must be called once symbolic execution is over, before the accessors
+  // below are used.
+  void finishExecution();
+
+  auto& functionDomain() const { return function_domain_joined; }
+  auto& returnDomain() const { return return_domain_joined; }
   smt::expr sinkDomain() const;
-  Memory returnMemory() const { return *return_memory(); }
+  const Memory& returnMemory() const { return *return_memory_joined; }
 
-  std::pair<StateValue, const std::set<smt::expr>&> returnVal() const {
-    return { *return_val(), return_undef_vars };
+  std::pair<const StateValue&, const std::set<smt::expr>&> returnVal() const {
+    return { return_val_joined, return_undef_vars };
   }
 
   void startParsingPre() { disable_undef_rewrite = true; }
@@ -421,7 +421,10 @@ expr FloatType::toInt(State &s, expr fp) const {
                 .concat(expr::mkInt(-1, exp_bits))
                 .concat(fraction);
   s.addPre(fraction != 0);
-  s.addQuantVar(var);
+  // as with freeze, only the src payloads are quantified
+  if (s.isSource())
+    s.addQuantVar(var);
+  s.addNaNVar(var);
 
   return expr::mkIf(isnan, nan, val);
 }
@@ -643,7 +646,7 @@ StateValue PtrType::fromInt(StateValue v) const {
 pair<expr, expr>
 PtrType::refines(State &src_s, State &tgt_s, const StateValue &src,
                  const StateValue &tgt) const {
-  auto sm = src_s.returnMemory(), tm = tgt_s.returnMemory();
+  auto &sm = src_s.returnMemory(), &tm = tgt_s.returnMemory();
   Pointer p(sm, src.value);
   Pointer q(tm, tgt.value);
 
@@ -222,7 +222,11 @@ StateValue Input::mkInput(State &s, const Type &ty, unsigned child) const {
 
   if (has_deref) {
     Pointer p(s.getMemory(), val);
-    s.addAxiom(p.isDereferenceable(attrs.derefBytes, bits_byte/8, false));
+    auto bid = p.getBid();
+    s.addPtrInputAxiom(bid,
+                       p.isDereferenceable(attrs.derefBytes, bits_byte/8,
+                                           false),
+                       "input-deref");
   }
 
   bool never_poison = config::disable_poison_input || attrs.poisonImpliesUB();
@@ -7,6 +7,8 @@
 #include "ir/instr.h"
 #include "util/config.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include <vector>
@@ -88,6 +90,47 @@ known_call(llvm::CallInst &i, const llvm::TargetLibraryInfo &TLI,
       }
     }
     RETURN_KNOWN(make_unique<Strlen>(*ty, value_name(i), *args[0]));
+  case llvm::LibFunc_memcpy:  // void* memcpy(void *dst, void *src, size_t n)
+  case llvm::LibFunc_memmove: // void* memmove(void *dst, void *src, size_t n)
+    BB.addInstr(make_unique<Memcpy>(*args[0], *args[1], *args[2], 1, 1,
+                                    libfn == llvm::LibFunc_memmove));
+    RETURN_KNOWN(make_unique<UnaryOp>(*ty, value_name(i), *args[0],
+                                      UnaryOp::Copy));
+  case llvm::LibFunc_strcpy:   // char* strcpy(char *dst, char *src)
+  case llvm::LibFunc_stpcpy: { // char* stpcpy(char *dst, char *src)
+    // n = strlen(src); memcpy(dst, src, n+1)
+    auto &DL = i.getModule()->getDataLayout();
+    auto &size_ty = get_int_type(DL.getIndexSizeInBits(0));
+    auto len = make_unique<Strlen>(size_ty, value_name(i) + "#strlen",
+                                   *args[1]);
+    auto len1 = make_unique<BinOp>(size_ty, value_name(i) + "#strlen1", *len,
+                                   *make_intconst(1, size_ty.bits()),
+                                   BinOp::Add);
+    auto &vlen = *len;
+    auto &vlen1 = *len1;
+    BB.addInstr(move(len));
+    BB.addInstr(move(len1));
+    BB.addInstr(make_unique<Memcpy>(*args[0], *args[1], vlen1, 1, 1, false));
+
+    if (libfn == llvm::LibFunc_strcpy)
+      RETURN_KNOWN(make_unique<UnaryOp>(*ty, value_name(i), *args[0],
+                                        UnaryOp::Copy));
+
+    // stpcpy returns a pointer to the terminator of dst
+    auto gep = make_unique<GEP>(*ty, value_name(i), *args[0], true);
+    gep->addIdx(1, vlen);
+    RETURN_KNOWN(move(gep));
+  }
+  case llvm::LibFunc_strcmp:
+    RETURN_KNOWN(make_unique<Strcmp>(*ty, value_name(i), *args[0], *args[1]));
+  case llvm::LibFunc_strncmp:
+    RETURN_KNOWN(make_unique<Strcmp>(*ty, value_name(i), *args[0], *args[1],
+                                     args[2]));
+  case llvm::LibFunc_strchr:
+    RETURN_KNOWN(make_unique<Memchr>(*ty, value_name(i), *args[0], *args[1]));
+  case llvm::LibFunc_memchr:
+    RETURN_KNOWN(make_unique<Memchr>(*ty, value_name(i), *args[0], *args[1],
+                                     args[2]));
   case llvm::LibFunc_memcmp:
   case llvm::LibFunc_bcmp: {
     RETURN_KNOWN(
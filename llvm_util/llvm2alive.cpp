@@ -101,9 +101,13 @@ void parse_fnattrs(FnAttrs &attrs, llvm::Type *retTy, Fn &&hasAttr,
   if (hasAttr(llvm::Attribute::WriteOnly))
     attrs.set(FnAttrs::NoRead);
 
-  if (hasAttr(llvm::Attribute::ArgMemOnly))
+  if (hasAttr(llvm::Attribute::ArgMemOnly) ||
+      hasAttr(llvm::Attribute::InaccessibleMemOrArgMemOnly))
     attrs.set(FnAttrs::ArgMemOnly);
 
+  if (hasAttr(llvm::Attribute::InaccessibleMemOnly))
+    attrs.set(FnAttrs::InaccessibleMemOnly);
+
   if (hasAttr(llvm::Attribute::NoFree))
     attrs.set(FnAttrs::NoFree);
 
@@ -356,6 +360,12 @@ public:
       if (i.paramHasAttr(argidx, llvm::Attribute::NonNull))
         attr.set(ParamAttrs::NonNull);
 
+      if (i.paramHasAttr(argidx, llvm::Attribute::ReadOnly))
+        attr.set(ParamAttrs::ReadOnly);
+
+      if (i.paramHasAttr(argidx, llvm::Attribute::ReadNone))
+        attr.set(ParamAttrs::ReadNone);
+
       if (i.paramHasAttr(argidx, llvm::Attribute::NoUndef)) {
         if (i.getArgOperand(argidx)->getType()->isAggregateType())
           // TODO: noundef aggregate should be supported; it can have undef
@@ -407,4 +407,13 @@ void reset_state(Function &f) {
   value_id_counter = 0;
 }
 
+void forget_types(const llvm::LLVMContext &ctx) {
+  for (auto I = type_cache.begin(); I != type_cache.end(); ) {
+    if (&I->first->getContext() == &ctx)
+      I = type_cache.erase(I);
+    else
+      ++I;
+  }
+}
+
 }
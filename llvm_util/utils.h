@@ -11,6 +11,7 @@ namespace llvm {
 class BasicBlock;
 class ConstantExpr;
 class DataLayout;
+class LLVMContext;
 class Type;
 class Value;
 }
@@ -47,4 +48,6 @@ PRINT(llvm::Value)
 
 void init_llvm_utils(std::ostream &os, const llvm::DataLayout &DL);
 void reset_state(IR::Function &f);
+// drops the cached types of ctx; call before destroying it
+void forget_types(const llvm::LLVMContext &ctx);
 }
@@ -0,0 +1,11 @@
+define i1 @src(iX %x) {
+    %c = call iX @llvm.ctlz.iX (iX %x, i1 false)
+    %r = icmp ult iX %c, X
+    ret i1 %r
+}
+
+define i1 @tgt(iX %x) {
+    ret i1 true
+}
+
+declare iX @llvm.ctlz.iX (iX, i1)
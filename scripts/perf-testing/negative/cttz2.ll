@@ -0,0 +1,12 @@
+define iX @src(iX %x) {
+    %c = call iX @llvm.cttz.iX (iX %x, i1 false)
+    ret iX %c
+}
+
+define iX @tgt(iX %x) {
+    %c = call iX @llvm.ctlz.iX (iX %x, i1 false)
+    ret iX %c
+}
+
+declare iX @llvm.cttz.iX (iX, i1)
+declare iX @llvm.ctlz.iX (iX, i1)
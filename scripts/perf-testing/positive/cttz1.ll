@@ -0,0 +1,12 @@
+define i1 @src(iX %x) {
+    %c = call iX @llvm.cttz.iX (iX %x, i1 false)
+    %r = icmp eq iX %c, X
+    ret i1 %r
+}
+
+define i1 @tgt(iX %x) {
+    %r = icmp eq iX %x, 0
+    ret i1 %r
+}
+
+declare iX @llvm.cttz.iX (iX, i1)
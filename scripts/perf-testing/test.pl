@@ -21,10 +21,12 @@ my $SMT_TO = 5000; # milliseconds
 # - probably eventually need to support multiple widths per test case: short, regular, long
 
 my $DEBUG = 0;
+my $ALIVE_ARGS = "";
 
 die "can't execute '${ALIVETV}'" unless -x $ALIVETV;
 
-GetOptions ("debug" => \$DEBUG)
+GetOptions ("debug" => \$DEBUG,
+            "alive-args=s" => \$ALIVE_ARGS)
     or die("Error in command line arguments\n");
 
 my $SPINNER_COUNT = -1;
@@ -41,7 +43,7 @@ sub check($$$) {
     system "m4 --define=iX=i${x} --define=X=${x} ${f} > ${tmpll}";
     system "cat ${tmpll}" if $DEBUG;
     my $tmpout = File::Temp->new();
-    system "${ALIVETV} --smt-to=${SMT_TO} ${tmpll} > $tmpout 2>&1";
+    system "${ALIVETV} --smt-to=${SMT_TO} ${ALIVE_ARGS} ${tmpll} > $tmpout 2>&1";
     system "cat ${tmpout}" if $DEBUG;
     open my $INF, "<$tmpout" or die;
     while (my $line = <$INF>) {
@@ -0,0 +1,921 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "smt/aig.h"
+#include "smt/ctx.h"
+#include "smt/smt.h"
+#include "util/compiler.h"
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <z3.h>
+
+using namespace smt;
+using namespace std;
+
+using Lit = AIG::Lit;
+using Bits = vector<Lit>;
+
+static unsigned num_queries = 0;
+static unsigned num_unsupported = 0;
+static unsigned num_trivial = 0;
+static unsigned num_merged = 0;
+
+// bigger queries are left to Z3
+static constexpr unsigned max_nodes = 4'000'000;
+// max number of equivalence checks done by SAT sweeping per query
+static constexpr unsigned max_sweep_checks = 5000;
+
+namespace smt {
+
+AIG::AIG() {
+  nodes.push_back({ None, None });
+}
+
+AIG::Lit AIG::mkInput() {
+  unsigned n = nodes.size();
+  nodes.push_back({ None, None });
+  inputs.push_back(n);
+  return mkLit(n);
+}
+
+AIG::Lit AIG::mkAnd(Lit a, Lit b) {
+  if (a > b)
+    swap(a, b);
+  if (a == False)
+    return False;
+  if (a == True || a == b)
+    return b;
+  if (a == neg(b))
+    return False;
+
+  // two-level rules when an operand is an AND gate
+  for (auto [x, y] : { pair(a, b), pair(b, a) }) {
+    auto n = node(y);
+    if (!isAnd(n))
+      continue;
+    Lit y0 = nodes[n].in0, y1 = nodes[n].in1;
+    if (!isNeg(y)) {
+      // x & (x & z) -> x & z
+      if (x == y0 || x == y1)
+        return y;
+      // x & (~x & z) -> false
+      if (x == neg(y0) || x == neg(y1))
+        return False;
+    } else {
+      // x & ~(~x & z) -> x
+      if (x == neg(y0) || x == neg(y1))
+        return x;
+      // x & ~(x & z) -> x & ~z
+      if (x == y0)
+        return mkAnd(x, neg(y1));
+      if (x == y1)
+        return mkAnd(x, neg(y0));
+    }
+  }
+
+  auto [I, inserted] = strash.emplace((uint64_t)a << 32 | b, 0);
+  if (inserted) {
+    I->second = mkLit(nodes.size());
+    nodes.push_back({ a, b });
+  }
+  return I->second;
+}
+
+AIG::Lit AIG::mkXor(Lit a, Lit b) {
+  // move complements to the output so that equivalent XORs are shared
+  bool compl_out = isNeg(a) ^ isNeg(b);
+  a &= ~1u;
+  b &= ~1u;
+  if (a > b)
+    swap(a, b);
+
+  Lit res;
+  if (a == False) {
+    res = b;
+  } else if (a == b) {
+    res = False;
+  } else {
+    uint64_t key = (uint64_t)a << 32 | b;
+    auto I = xors.find(key);
+    if (I != xors.end()) {
+      res = I->second;
+    } else {
+      res = mkOr(mkAnd(a, neg(b)), mkAnd(neg(a), b));
+      xors.emplace(key, res);
+    }
+  }
+  return res ^ compl_out;
+}
+
+AIG::Lit AIG::mkIte(Lit c, Lit a, Lit b) {
+  if (c == True || a == b)
+    return a;
+  if (c == False)
+    return b;
+  if (a == True)
+    return mkOr(c, b);
+  if (a == False)
+    return mkAnd(neg(c), b);
+  if (b == True)
+    return mkOr(neg(c), a);
+  if (b == False)
+    return mkAnd(c, a);
+  if (a == neg(b))
+    return mkXor(neg(c), a);
+  return mkOr(mkAnd(c, a), mkAnd(neg(c), b));
+}
+
+vector<uint64_t> AIG::simulate(const vector<uint64_t> &in) const {
+  assert(in.size() == inputs.size());
+  vector<uint64_t> val(nodes.size());
+  auto lit = [&](Lit l) { return isNeg(l) ? ~val[node(l)] : val[node(l)]; };
+
+  unsigned i = 0;
+  for (unsigned n = 1, e = nodes.size(); n != e; ++n) {
+    val[n] = isInput(n) ? in[i++] : lit(nodes[n].in0) & lit(nodes[n].in1);
+  }
+  return val;
+}
+
+}
+
+
+static Bits numeral_bits(Z3_ast a, unsigned width) {
+  Bits bits;
+  uint64_t n;
+  if (width <= 64 && Z3_get_numeral_uint64(ctx(), a, &n)) {
+    for (unsigned i = 0; i < width; ++i) {
+      bits.push_back((n >> i) & 1 ? AIG::True : AIG::False);
+    }
+    return bits;
+  }
+
+  // repeatedly divide the decimal string by 2
+  string str = Z3_get_numeral_string(ctx(), a);
+  while (bits.size() < width) {
+    string quot;
+    unsigned rem = 0;
+    for (char c : str) {
+      unsigned d = rem * 10 + (c - '0');
+      if (!quot.empty() || d >= 2)
+        quot += char('0' + d / 2);
+      rem = d % 2;
+    }
+    bits.push_back(rem ? AIG::True : AIG::False);
+    str = quot.empty() ? "0" : move(quot);
+  }
+  return bits;
+}
+
+static Bits add(AIG &aig, const Bits &a, const Bits &b, Lit carry) {
+  Bits res(a.size());
+  for (unsigned i = 0, e = a.size(); i != e; ++i) {
+    Lit x = aig.mkXor(a[i], b[i]);
+    res[i] = aig.mkXor(x, carry);
+    carry = aig.mkOr(aig.mkAnd(a[i], b[i]), aig.mkAnd(carry, x));
+  }
+  return res;
+}
+
+static Bits bvnot(const Bits &a) {
+  Bits res(a.size());
+  for (unsigned i = 0, e = a.size(); i != e; ++i) {
+    res[i] = AIG::neg(a[i]);
+  }
+  return res;
+}
+
+static Bits sub(AIG &aig, const Bits &a, const Bits &b) {
+  return add(aig, a, bvnot(b), AIG::True);
+}
+
+static Bits bvneg(AIG &aig, const Bits &a) {
+  return add(aig, bvnot(a), Bits(a.size(), AIG::False), AIG::True);
+}
+
+static Bits mul(AIG &aig, const Bits &a, const Bits &b) {
+  unsigned n = a.size();
+  Bits res(n, AIG::False);
+  for (unsigned i = 0; i < n; ++i) {
+    if (b[i] == AIG::False)
+      continue;
+    Bits row(n, AIG::False);
+    for (unsigned j = i; j < n; ++j) {
+      row[j] = aig.mkAnd(a[j - i], b[i]);
+    }
+    res = add(aig, res, row, AIG::False);
+  }
+  return res;
+}
+
+static Bits ite(AIG &aig, Lit c, const Bits &a, const Bits &b) {
+  Bits res(a.size());
+  for (unsigned i = 0, e = a.size(); i != e; ++i) {
+    res[i] = aig.mkIte(c, a[i], b[i]);
+  }
+  return res;
+}
+
+static Lit eq(AIG &aig, const Bits &a, const Bits &b) {
+  Lit res = AIG::True;
+  for (unsigned i = 0, e = a.size(); i != e; ++i) {
+    res = aig.mkAnd(res, AIG::neg(aig.mkXor(a[i], b[i])));
+  }
+  return res;
+}
+
+static Lit ult(AIG &aig, const Bits &a, const Bits &b, bool is_signed = false) {
+  Lit lt = AIG::False;
+  for (unsigned i = 0, e = a.size(); i != e; ++i) {
+    // the sign bits of a signed comparison are compared the other way around
+    Lit b_bit = is_signed && i == e-1 ? a[i] : b[i];
+    lt = aig.mkIte(aig.mkXor(a[i], b[i]), b_bit, lt);
+  }
+  return lt;
+}
+
+enum ShiftKind { Shl, LShr, AShr };
+
+static Bits shift(AIG &aig, const Bits &a, const Bits &amount, ShiftKind kind) {
+  unsigned n = a.size();
+  Lit fill = kind == AShr ? a.back() : AIG::False;
+  Lit overflow = AIG::False;
+  Bits res = a;
+
+  for (unsigned k = 0, e = amount.size(); k != e; ++k) {
+    if (k >= 32 || (1ull << k) >= n) {
+      overflow = aig.mkOr(overflow, amount[k]);
+      continue;
+    }
+    unsigned amt = 1u << k;
+    Bits shifted(n);
+    for (unsigned i = 0; i < n; ++i) {
+      if (kind == Shl)
+        shifted[i] = i >= amt ? res[i - amt] : AIG::False;
+      else
+        shifted[i] = i + amt < n ? res[i + amt] : fill;
+    }
+    res = ite(aig, amount[k], shifted, res);
+  }
+  return ite(aig, overflow, Bits(n, fill), res);
+}
+
+// restoring division; matches SMT-LIB's semantics for division by zero
+static void udivrem(AIG &aig, const Bits &a, const Bits &d, Bits &q, Bits &r) {
+  unsigned n = a.size();
+  q.assign(n, AIG::False);
+  r.assign(n, AIG::False);
+  Bits dd = d;
+  dd.push_back(AIG::False);
+
+  for (int i = n - 1; i >= 0; --i) {
+    Bits t;
+    t.push_back(a[i]);
+    t.insert(t.end(), r.begin(), r.end());
+
+    Lit ge = AIG::neg(ult(aig, t, dd));
+    Bits diff = sub(aig, t, dd);
+    for (unsigned j = 0; j < n; ++j) {
+      r[j] = aig.mkIte(ge, diff[j], t[j]);
+    }
+    q[i] = ge;
+  }
+}
+
+static Bits bvabs(AIG &aig, const Bits &a) {
+  return ite(aig, a.back(), bvneg(aig, a), a);
+}
+
+
+namespace {
+class BitBlaster {
+  AIG &aig;
+  unordered_map<unsigned, Bits> cache; // ast id -> bits
+
+  bool blastNode(Z3_ast a, Bits &bits);
+
+public:
+  // free constants and their bits
+  vector<pair<Z3_ast, Bits>> consts;
+
+  BitBlaster(AIG &aig) : aig(aig) {}
+
+  bool blast(Z3_ast root, Bits &bits);
+};
+
+bool BitBlaster::blast(Z3_ast root, Bits &bits) {
+  vector<pair<Z3_ast, bool>> todo = { { root, false } };
+  while (!todo.empty()) {
+    auto [a, expanded] = todo.back();
+    unsigned id = Z3_get_ast_id(ctx(), a);
+    if (cache.count(id)) {
+      todo.pop_back();
+      continue;
+    }
+
+    if (!expanded) {
+      todo.back().second = true;
+      if (Z3_get_ast_kind(ctx(), a) == Z3_APP_AST) {
+        auto app = Z3_to_app(ctx(), a);
+        for (unsigned i = 0, e = Z3_get_app_num_args(ctx(), app); i != e; ++i){
+          todo.emplace_back(Z3_get_app_arg(ctx(), app, i), false);
+        }
+      }
+      continue;
+    }
+    todo.pop_back();
+
+    Bits res;
+    if (!blastNode(a, res) || aig.size() > max_nodes)
+      return false;
+    cache.emplace(id, move(res));
+  }
+  bits = cache.at(Z3_get_ast_id(ctx(), root));
+  return true;
+}
+
+bool BitBlaster::blastNode(Z3_ast a, Bits &bits) {
+  auto sort = Z3_get_sort(ctx(), a);
+  auto sort_kind = Z3_get_sort_kind(ctx(), sort);
+  if (sort_kind != Z3_BOOL_SORT && sort_kind != Z3_BV_SORT)
+    return false;
+  unsigned width = sort_kind == Z3_BV_SORT ? Z3_get_bv_sort_size(ctx(), sort)
+                                           : 1;
+
+  auto kind = Z3_get_ast_kind(ctx(), a);
+  if (kind == Z3_NUMERAL_AST) {
+    bits = numeral_bits(a, width);
+    return true;
+  }
+  if (kind != Z3_APP_AST)
+    return false;
+
+  auto app = Z3_to_app(ctx(), a);
+  auto decl = Z3_get_app_decl(ctx(), app);
+  vector<const Bits*> args;
+  for (unsigned i = 0, e = Z3_get_app_num_args(ctx(), app); i != e; ++i) {
+    args.emplace_back(&cache.at(Z3_get_ast_id(ctx(),
+                                              Z3_get_app_arg(ctx(), app, i))));
+  }
+  auto param = [&](unsigned i) {
+    return (unsigned)Z3_get_decl_int_parameter(ctx(), decl, i);
+  };
+  auto fold = [&](Lit (AIG::*op)(Lit, Lit)) {
+    bits = *args[0];
+    for (unsigned i = 1, e = args.size(); i != e; ++i) {
+      for (unsigned j = 0; j < width; ++j) {
+        bits[j] = (aig.*op)(bits[j], (*args[i])[j]);
+      }
+    }
+  };
+  auto lit = [&](unsigned i) { return (*args[i])[0]; };
+
+  switch (Z3_get_decl_kind(ctx(), decl)) {
+  case Z3_OP_UNINTERPRETED:
+    if (!args.empty())
+      return false;
+    for (unsigned i = 0; i < width; ++i) {
+      bits.emplace_back(aig.mkInput());
+    }
+    consts.emplace_back(a, bits);
+    break;
+
+  case Z3_OP_TRUE:
+  case Z3_OP_BIT1:
+    bits = { AIG::True };
+    break;
+  case Z3_OP_FALSE:
+  case Z3_OP_BIT0:
+    bits = { AIG::False };
+    break;
+  case Z3_OP_EQ:
+  case Z3_OP_IFF:
+    bits = { eq(aig, *args[0], *args[1]) };
+    break;
+  case Z3_OP_DISTINCT: {
+    Lit res = AIG::True;
+    for (unsigned i = 0, e = args.size(); i != e; ++i) {
+      for (unsigned j = i + 1; j != e; ++j) {
+        res = aig.mkAnd(res, AIG::neg(eq(aig, *args[i], *args[j])));
+      }
+    }
+    bits = { res };
+    break;
+  }
+  case Z3_OP_ITE:
+    bits = ite(aig, lit(0), *args[1], *args[2]);
+    break;
+  case Z3_OP_AND:
+  case Z3_OP_BAND:
+    fold(&AIG::mkAnd);
+    break;
+  case Z3_OP_OR:
+  case Z3_OP_BOR:
+    fold(&AIG::mkOr);
+    break;
+  case Z3_OP_XOR:
+  case Z3_OP_BXOR:
+    fold(&AIG::mkXor);
+    break;
+  case Z3_OP_NOT:
+  case Z3_OP_BNOT:
+    bits = bvnot(*args[0]);
+    break;
+  case Z3_OP_IMPLIES:
+    bits = { aig.mkOr(AIG::neg(lit(0)), lit(1)) };
+    break;
+  case Z3_OP_BNAND:
+    fold(&AIG::mkAnd);
+    bits = bvnot(bits);
+    break;
+  case Z3_OP_BNOR:
+    fold(&AIG::mkOr);
+    bits = bvnot(bits);
+    break;
+  case Z3_OP_BXNOR:
+    fold(&AIG::mkXor);
+    bits = bvnot(bits);
+    break;
+
+  case Z3_OP_BNEG:
+    bits = bvneg(aig, *args[0]);
+    break;
+  case Z3_OP_BADD:
+    bits = *args[0];
+    for (unsigned i = 1, e = args.size(); i != e; ++i) {
+      bits = add(aig, bits, *args[i], AIG::False);
+    }
+    break;
+  case Z3_OP_BSUB:
+    bits = sub(aig, *args[0], *args[1]);
+    break;
+  case Z3_OP_BMUL:
+    bits = *args[0];
+    for (unsigned i = 1, e = args.size(); i != e; ++i) {
+      bits = mul(aig, bits, *args[i]);
+    }
+    break;
+  case Z3_OP_BUDIV:
+  case Z3_OP_BUDIV_I:
+  case Z3_OP_BUREM:
+  case Z3_OP_BUREM_I: {
+    Bits q, r;
+    udivrem(aig, *args[0], *args[1], q, r);
+    auto k = Z3_get_decl_kind(ctx(), decl);
+    bits = k == Z3_OP_BUDIV || k == Z3_OP_BUDIV_I ? q : r;
+    break;
+  }
+  case Z3_OP_BSDIV:
+  case Z3_OP_BSDIV_I:
+  case Z3_OP_BSREM:
+  case Z3_OP_BSREM_I:
+  case Z3_OP_BSMOD:
+  case Z3_OP_BSMOD_I: {
+    auto &x = *args[0], &y = *args[1];
+    Lit sx = x.back(), sy = y.back();
+    Bits q, r;
+    udivrem(aig, bvabs(aig, x), bvabs(aig, y), q, r);
+
+    switch (Z3_get_decl_kind(ctx(), decl)) {
+    case Z3_OP_BSDIV:
+    case Z3_OP_BSDIV_I:
+      bits = ite(aig, aig.mkXor(sx, sy), bvneg(aig, q), q);
+      break;
+    case Z3_OP_BSREM:
+    case Z3_OP_BSREM_I:
+      bits = ite(aig, sx, bvneg(aig, r), r);
+      break;
+    default: {
+      auto neg_r = bvneg(aig, r);
+      bits = ite(aig, eq(aig, r, Bits(width, AIG::False)), r,
+                 ite(aig, sx,
+                     ite(aig, sy, neg_r, add(aig, neg_r, y, AIG::False)),
+                     ite(aig, sy, add(aig, r, y, AIG::False), r)));
+      break;
+    }
+    }
+    break;
+  }
+
+  case Z3_OP_ULEQ:
+    bits = { AIG::neg(ult(aig, *args[1], *args[0])) };
+    break;
+  case Z3_OP_SLEQ:
+    bits = { AIG::neg(ult(aig, *args[1], *args[0], true)) };
+    break;
+  case Z3_OP_UGEQ:
+    bits = { AIG::neg(ult(aig, *args[0], *args[1])) };
+    break;
+  case Z3_OP_SGEQ:
+    bits = { AIG::neg(ult(aig, *args[0], *args[1], true)) };
+    break;
+  case Z3_OP_ULT:
+    bits = { ult(aig, *args[0], *args[1]) };
+    break;
+  case Z3_OP_SLT:
+    bits = { ult(aig, *args[0], *args[1], true) };
+    break;
+  case Z3_OP_UGT:
+    bits = { ult(aig, *args[1], *args[0]) };
+    break;
+  case Z3_OP_SGT:
+    bits = { ult(aig, *args[1], *args[0], true) };
+    break;
+
+  case Z3_OP_CONCAT:
+    for (auto I = args.rbegin(), E = args.rend(); I != E; ++I) {
+      bits.insert(bits.end(), (*I)->begin(), (*I)->end());
+    }
+    break;
+  case Z3_OP_EXTRACT:
+    bits.assign(args[0]->begin() + param(1), args[0]->begin() + param(0) + 1);
+    break;
+  case Z3_OP_ZERO_EXT:
+    bits = *args[0];
+    bits.resize(width, AIG::False);
+    break;
+  case Z3_OP_SIGN_EXT:
+    bits = *args[0];
+    bits.resize(width, args[0]->back());
+    break;
+  case Z3_OP_REPEAT:
+    for (unsigned i = 0, e = param(0); i != e; ++i) {
+      bits.insert(bits.end(), args[0]->begin(), args[0]->end());
+    }
+    break;
+  case Z3_OP_ROTATE_LEFT:
+  case Z3_OP_ROTATE_RIGHT: {
+    unsigned n = args[0]->size();
+    unsigned amt = param(0) % n;
+    if (Z3_get_decl_kind(ctx(), decl) == Z3_OP_ROTATE_RIGHT)
+      amt = (n - amt) % n;
+    bits.resize(n);
+    for (unsigned i = 0; i < n; ++i) {
+      bits[(i + amt) % n] = (*args[0])[i];
+    }
+    break;
+  }
+  case Z3_OP_BREDOR: {
+    Lit res = AIG::False;
+    for (auto b : *args[0]) {
+      res = aig.mkOr(res, b);
+    }
+    bits = { res };
+    break;
+  }
+  case Z3_OP_BREDAND: {
+    Lit res = AIG::True;
+    for (auto b : *args[0]) {
+      res = aig.mkAnd(res, b);
+    }
+    bits = { res };
+    break;
+  }
+  case Z3_OP_BCOMP:
+    bits = { eq(aig, *args[0], *args[1]) };
+    break;
+  case Z3_OP_BSHL:
+    bits = shift(aig, *args[0], *args[1], Shl);
+    break;
+  case Z3_OP_BLSHR:
+    bits = shift(aig, *args[0], *args[1], LShr);
+    break;
+  case Z3_OP_BASHR:
+    bits = shift(aig, *args[0], *args[1], AShr);
+    break;
+
+  default:
+    return false;
+  }
+  assert(bits.size() == width);
+  return true;
+}
+
+
+// CNF of (parts of) an AIG in Z3's SAT solver. Nodes are encoded on demand
+class SatSolver {
+  const AIG &aig;
+  Z3_solver s;
+  vector<Z3_ast> vars, neg_vars;
+
+  Z3_ast mkRef(Z3_ast a) {
+    Z3_inc_ref(ctx(), a);
+    return a;
+  }
+
+  void addClause(initializer_list<Z3_ast> lits) {
+    Z3_solver_assert(ctx(), s, Z3_mk_or(ctx(), lits.size(), lits.begin()));
+  }
+
+  void encode(unsigned root) {
+    vector<unsigned> todo = { root };
+    while (!todo.empty()) {
+      unsigned n = todo.back();
+      if (vars[n]) {
+        todo.pop_back();
+        continue;
+      }
+
+      if (aig.isAnd(n)) {
+        unsigned n0 = AIG::node(aig.in0(n)), n1 = AIG::node(aig.in1(n));
+        if (!vars[n0] || !vars[n1]) {
+          todo.push_back(n0);
+          todo.push_back(n1);
+          continue;
+        }
+      }
+      todo.pop_back();
+
+      if (n == 0) {
+        vars[n] = mkRef(Z3_mk_false(ctx()));
+        neg_vars[n] = mkRef(Z3_mk_true(ctx()));
+        continue;
+      }
+      vars[n] = mkRef(Z3_mk_const(ctx(), Z3_mk_int_symbol(ctx(), n),
+                                  Z3_mk_bool_sort(ctx())));
+      neg_vars[n] = mkRef(Z3_mk_not(ctx(), vars[n]));
+
+      if (aig.isAnd(n)) {
+        // n <-> a & b
+        auto a = lit(aig.in0(n)), b = lit(aig.in1(n));
+        auto na = lit(AIG::neg(aig.in0(n))), nb = lit(AIG::neg(aig.in1(n)));
+        addClause({ neg_vars[n], a });
+        addClause({ neg_vars[n], b });
+        addClause({ vars[n], na, nb });
+      }
+    }
+  }
+
+public:
+  SatSolver(const AIG &aig)
+    : aig(aig), vars(aig.size(), nullptr), neg_vars(aig.size(), nullptr) {
+    s = Z3_mk_solver_for_logic(ctx(), Z3_mk_string_symbol(ctx(), "QF_FD"));
+    Z3_solver_inc_ref(ctx(), s);
+  }
+
+  ~SatSolver() {
+    for (unsigned i = 0, e = vars.size(); i != e; ++i) {
+      if (vars[i]) {
+        Z3_dec_ref(ctx(), vars[i]);
+        Z3_dec_ref(ctx(), neg_vars[i]);
+      }
+    }
+    Z3_solver_dec_ref(ctx(), s);
+  }
+
+  Z3_ast lit(Lit l) {
+    auto n = AIG::node(l);
+    encode(n);
+    return AIG::isNeg(l) ? neg_vars[n] : vars[n];
+  }
+
+  void add(Lit l) {
+    Z3_solver_assert(ctx(), s, lit(l));
+  }
+
+  // QF_FD solvers don't pick up the global timeout; set it explicitly
+  void setTimeout(unsigned ms) {
+    auto p = Z3_mk_params(ctx());
+    Z3_params_inc_ref(ctx(), p);
+    Z3_params_set_uint(ctx(), p, Z3_mk_string_symbol(ctx(), "timeout"), ms);
+    Z3_solver_set_params(ctx(), s, p);
+    Z3_params_dec_ref(ctx(), p);
+  }
+
+  Z3_lbool check() {
+    return Z3_solver_check(ctx(), s);
+  }
+
+  // returns true if a and b are proved equivalent
+  bool equivalent(Lit a, Lit b) {
+    auto la = lit(a), lb = lit(b), na = lit(AIG::neg(a)), nb = lit(AIG::neg(b));
+    auto miter = mkRef(Z3_mk_fresh_const(ctx(), "miter",
+                                         Z3_mk_bool_sort(ctx())));
+    auto not_miter = mkRef(Z3_mk_not(ctx(), miter));
+    addClause({ not_miter, la, lb });
+    addClause({ not_miter, na, nb });
+
+    bool equiv = Z3_solver_check_assumptions(ctx(), s, 1, &miter)
+                   == Z3_L_FALSE;
+    if (equiv) {
+      addClause({ na, lb });
+      addClause({ la, nb });
+    }
+    Z3_dec_ref(ctx(), miter);
+    Z3_dec_ref(ctx(), not_miter);
+    return equiv;
+  }
+
+  // assignment to the inputs of the AIG in the last model
+  vector<uint64_t> inputValues() {
+    vector<uint64_t> vals;
+    auto m = Z3_solver_get_model(ctx(), s);
+    Z3_model_inc_ref(ctx(), m);
+    for (unsigned n = 1, e = aig.size(); n != e; ++n) {
+      if (!aig.isInput(n))
+        continue;
+      Z3_ast v;
+      bool val = vars[n] && Z3_model_eval(ctx(), m, vars[n], true, &v) &&
+                 Z3_get_bool_value(ctx(), v) == Z3_L_TRUE;
+      vals.push_back(val ? ~0ull : 0);
+    }
+    Z3_model_dec_ref(ctx(), m);
+    return vals;
+  }
+};
+}
+
+// time left until the deadline; at least 1 ms as 0 disables Z3's timeout
+static unsigned ms_until(chrono::steady_clock::time_point deadline) {
+  auto left = chrono::duration_cast<chrono::milliseconds>(
+                deadline - chrono::steady_clock::now()).count();
+  return left > 0 ? left : 1;
+}
+
+static vector<bool> cone_of(const AIG &aig, Lit root) {
+  vector<bool> cone(aig.size(), false);
+  vector<unsigned> todo = { AIG::node(root) };
+  while (!todo.empty()) {
+    unsigned n = todo.back();
+    todo.pop_back();
+    if (cone[n])
+      continue;
+    cone[n] = true;
+    if (aig.isAnd(n)) {
+      todo.push_back(AIG::node(aig.in0(n)));
+      todo.push_back(AIG::node(aig.in1(n)));
+    }
+  }
+  return cone;
+}
+
+// Merge nodes that are proved equivalent. Candidates are the nodes with equal
+// signatures under random simulation. Returns the root of the new AIG; map
+// translates nodes of the old AIG into literals of the new one.
+static Lit sweep(const AIG &aig, Lit root, AIG &out, vector<Lit> &map,
+                 chrono::steady_clock::time_point deadline) {
+  constexpr unsigned words = 4;
+  unsigned num_inputs = 0;
+  for (unsigned n = 1, e = aig.size(); n != e; ++n) {
+    num_inputs += aig.isInput(n);
+  }
+
+  mt19937_64 rng(0);
+  vector<vector<uint64_t>> sims;
+  for (unsigned w = 0; w < words; ++w) {
+    vector<uint64_t> in(num_inputs);
+    for (auto &v : in) {
+      v = rng();
+    }
+    sims.emplace_back(aig.simulate(in));
+  }
+
+  // classes of candidate equivalent nodes (modulo complement)
+  auto cone = cone_of(aig, root);
+  std::map<vector<uint64_t>, vector<unsigned>> classes;
+  vector<bool> phase(aig.size());
+  for (unsigned n = 0, e = aig.size(); n != e; ++n) {
+    if (!cone[n] && n != 0)
+      continue;
+    phase[n] = sims[0][n] & 1;
+    vector<uint64_t> sig(words);
+    for (unsigned w = 0; w < words; ++w) {
+      sig[w] = phase[n] ? ~sims[w][n] : sims[w][n];
+    }
+    classes[move(sig)].push_back(n);
+  }
+
+  vector<Lit> repl(aig.size());
+  for (unsigned n = 0, e = aig.size(); n != e; ++n) {
+    repl[n] = AIG::mkLit(n);
+  }
+
+  SatSolver sat(aig);
+  unsigned checks = 0;
+  for (auto &[sig, nodes] : classes) {
+    // the first node is the one with the smallest index
+    unsigned repr = nodes[0];
+    for (unsigned i = 1, e = nodes.size(); i != e; ++i) {
+      if (++checks > max_sweep_checks || chrono::steady_clock::now() > deadline)
+        goto done;
+      sat.setTimeout(ms_until(deadline));
+      unsigned n = nodes[i];
+      Lit r = AIG::mkLit(repr, phase[n] != phase[repr]);
+      if (sat.equivalent(AIG::mkLit(n), r)) {
+        repl[n] = r;
+        ++num_merged;
+      }
+    }
+  }
+done:
+
+  auto translate = [&](Lit l) { return map[AIG::node(l)] ^ AIG::isNeg(l); };
+  map.assign(aig.size(), AIG::False);
+  for (unsigned n = 1, e = aig.size(); n != e; ++n) {
+    if (aig.isInput(n))
+      map[n] = out.mkInput();
+    else if (!cone[n])
+      continue;
+    else if (repl[n] != AIG::mkLit(n))
+      map[n] = translate(repl[n]);
+    else
+      map[n] = out.mkAnd(translate(aig.in0(n)), translate(aig.in1(n)));
+  }
+  return translate(root);
+}
+
+namespace smt {
+
+AIGAnswer aig_check(const vector<Z3_ast> &assertions, bool do_sweep,
+                    unsigned timeout_ms, vector<expr> &model) {
+  ++num_queries;
+  auto start = chrono::steady_clock::now();
+  AIG aig;
+  BitBlaster bb(aig);
+  Lit root = AIG::True;
+  for (auto a : assertions) {
+    Bits bits;
+    if (!bb.blast(a, bits)) {
+      ++num_unsupported;
+      return AIGAnswer::UNSUPPORTED;
+    }
+    root = aig.mkAnd(root, bits[0]);
+  }
+
+  AIG swept;
+  const AIG *final_aig = &aig;
+  vector<Lit> map;
+  if (do_sweep && root != AIG::True && root != AIG::False) {
+    // leave at least half of the time for the final SAT query
+    auto deadline = start + chrono::milliseconds(timeout_ms / 2);
+    root = sweep(aig, root, swept, map, deadline);
+    final_aig = &swept;
+  }
+
+  if (root == AIG::False) {
+    ++num_trivial;
+    return AIGAnswer::UNSAT;
+  }
+
+  SatSolver sat(*final_aig);
+  vector<uint64_t> inputs;
+  if (root == AIG::True) {
+    ++num_trivial;
+    for (unsigned n = 1, e = final_aig->size(); n != e; ++n) {
+      if (final_aig->isInput(n))
+        inputs.push_back(0);
+    }
+  } else {
+    // the SAT query gets what is left of the budget after sweeping
+    sat.setTimeout(ms_until(start + chrono::milliseconds(timeout_ms)));
+    sat.add(root);
+    switch (sat.check()) {
+    case Z3_L_FALSE: return AIGAnswer::UNSAT;
+    case Z3_L_UNDEF: return AIGAnswer::UNKNOWN;
+    case Z3_L_TRUE:  break;
+    }
+    inputs = sat.inputValues();
+  }
+
+  auto vals = final_aig->simulate(inputs);
+  auto value = [&](Lit l) {
+    if (final_aig != &aig)
+      l = map[AIG::node(l)] ^ AIG::isNeg(l);
+    return (vals[AIG::node(l)] & 1) ^ AIG::isNeg(l);
+  };
+
+  for (auto &[var, bits] : bb.consts) {
+    expr v(var);
+    if (v.isBool()) {
+      model.emplace_back(v == expr(value(bits[0]) != 0));
+      continue;
+    }
+    expr val;
+    for (unsigned i = 0, e = bits.size(); i < e; i += 64) {
+      unsigned chunk_bits = min(64u, e - i);
+      uint64_t n = 0;
+      for (unsigned j = 0; j < chunk_bits; ++j) {
+        n |= (uint64_t)value(bits[i + j]) << j;
+      }
+      auto chunk = expr::mkUInt(n, chunk_bits);
+      val = val.isValid() ? chunk.concat(val) : chunk;
+    }
+    model.emplace_back(v == val);
+  }
+  return AIGAnswer::SAT;
+}
+
+void aig_print_stats(ostream &os) {
+  if (num_queries == 0)
+    return;
+  os << "Num AIG queries: " << num_queries
+     << " (unsupported: " << num_unsupported
+     << ", solved by hashing/sweeping: " << num_trivial
+     << ", merged nodes: " << num_merged << ")\n";
+}
+
+}
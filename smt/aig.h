@@ -0,0 +1,73 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "smt/expr.h"
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+typedef struct _Z3_ast* Z3_ast;
+
+namespace smt {
+
+// And-inverter graph with structural hashing.
+// A literal is a node index times 2, plus 1 if complemented. Node 0 is the
+// constant false. Nodes are created in topological order.
+class AIG {
+public:
+  using Lit = unsigned;
+  static constexpr Lit False = 0;
+  static constexpr Lit True = 1;
+
+  static Lit mkLit(unsigned node, bool neg = false) { return 2*node + neg; }
+  static unsigned node(Lit l) { return l >> 1; }
+  static bool isNeg(Lit l) { return l & 1; }
+  static Lit neg(Lit l) { return l ^ 1; }
+
+  AIG();
+
+  Lit mkInput();
+  Lit mkAnd(Lit a, Lit b);
+  Lit mkOr(Lit a, Lit b) { return neg(mkAnd(neg(a), neg(b))); }
+  Lit mkXor(Lit a, Lit b);
+  Lit mkIte(Lit c, Lit a, Lit b);
+
+  unsigned size() const { return nodes.size(); }
+  bool isInput(unsigned n) const { return n != 0 && nodes[n].in0 == None; }
+  bool isAnd(unsigned n) const { return n != 0 && nodes[n].in0 != None; }
+  Lit in0(unsigned n) const { return nodes[n].in0; }
+  Lit in1(unsigned n) const { return nodes[n].in1; }
+
+  // evaluate 64 input patterns at once; returns a word per node
+  std::vector<uint64_t> simulate(const std::vector<uint64_t> &inputs) const;
+
+private:
+  static constexpr Lit None = ~0u;
+  struct Node {
+    Lit in0, in1;
+  };
+  std::vector<Node> nodes;
+  std::vector<unsigned> inputs;
+  std::unordered_map<uint64_t, Lit> strash;
+  std::unordered_map<uint64_t, Lit> xors;
+};
+
+
+// Decides a conjunction of quantifier-free bit-vector formulas by
+// bit-blasting them into an AIG. The CNF of what is left after hashing (and
+// optionally SAT sweeping) is given to Z3's SAT solver.
+enum class AIGAnswer { SAT, UNSAT, UNKNOWN, UNSUPPORTED };
+
+// timeout_ms is shared by sweeping and the final SAT query.
+// on SAT, model is filled with equalities between the free constants of the
+// formula and their values
+AIGAnswer aig_check(const std::vector<Z3_ast> &assertions, bool sweep,
+                    unsigned timeout_ms, std::vector<expr> &model);
+
+void aig_print_stats(std::ostream &os);
+
+}
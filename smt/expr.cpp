@@ -3,12 +3,16 @@
 
 #include "smt/expr.h"
 #include "smt/ctx.h"
+#include "smt/smt.h"
 #include "util/compiler.h"
 #include <algorithm>
 #include <cassert>
 #include <limits>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <z3.h>
 
 #define DEBUG_Z3_RC 0
@@ -304,6 +308,11 @@ bool expr::isVar() const {
   return false;
 }
 
+bool expr::isSameSort(const expr &rhs) const {
+  C(rhs);
+  return sort() == rhs.sort();
+}
+
 bool expr::isBV() const {
   C();
   return Z3_get_sort_kind(ctx(), sort()) == Z3_BV_SORT;
@@ -437,6 +446,10 @@ bool expr::isAdd(expr &a, expr &b) const {
   return isBinOp(a, b, Z3_OP_BADD);
 }
 
+bool expr::isMul(expr &a, expr &b) const {
+  return isBinOp(a, b, Z3_OP_BMUL);
+}
+
 bool expr::isBasePlusOffset(expr &base, uint64_t &offset) const {
   expr a, b;
   if (isAdd(a, b)) {
@@ -839,11 +852,101 @@ expr expr::bitreverse() const {
   return res;
 }
 
+// smallest power of 2 >= n
+static unsigned next_pow2(unsigned n) {
+  unsigned p = 1;
+  while (p < n)
+    p *= 2;
+  return p;
+}
+
+// number of leading zeros of a non-zero bit-vector whose width is a power of 2
+// each step checks if the upper half of the remaining window is zero, which
+// gives one bit of the result
+static expr ctlz_bsearch(expr e, unsigned out_bits) {
+  auto nbits = e.bits();
+  assert(nbits > 1 && (nbits & (nbits - 1)) == 0);
+
+  expr res;
+  for (unsigned k = nbits / 2; k > 0; k /= 2) {
+    expr is_zero = e.extract(nbits - 1, nbits - k) == 0;
+    auto bit = is_zero.toBVBool();
+    res = res.isValid() ? res.concat(bit) : bit;
+    e = expr::mkIf(is_zero, e.extract(nbits - k - 1, 0).concat_zeros(k), e);
+  }
+  return res.zextOrTrunc(out_bits);
+}
+
+// a mask with alternating groups of k zeros and k ones, starting with ones at
+// the lsb
+static expr swar_mask(unsigned k, unsigned nbits) {
+  auto group = expr::mkUInt(0, k).concat(expr::mkInt(-1, k));
+  auto res = group;
+  for (unsigned i = 2*k; i < nbits; i += 2*k) {
+    res = group.concat(res);
+  }
+  return res;
+}
+
+static expr ctpop_swar(const expr &e) {
+  auto nbits = e.bits();
+  auto pbits = next_pow2(nbits);
+  auto v = e.zext(pbits - nbits);
+  for (unsigned k = 1; k < pbits; k *= 2) {
+    auto mask = swar_mask(k, pbits);
+    v = (v & mask) + (v.lshr(expr::mkUInt(k, pbits)) & mask);
+  }
+  return v.trunc(nbits);
+}
+
+static expr ctpop_tree(const expr &e) {
+  auto nbits = e.bits();
+  vector<expr> terms;
+  for (unsigned i = 0; i < nbits; ++i) {
+    terms.emplace_back(e.extract(i, i));
+  }
+
+  // sum pairs of terms, growing each level by 1 bit to fit the carry
+  while (terms.size() > 1) {
+    vector<expr> next;
+    for (unsigned i = 0; i + 1 < terms.size(); i += 2) {
+      next.emplace_back(terms[i].zext(1) + terms[i+1].zext(1));
+    }
+    if (terms.size() % 2)
+      next.emplace_back(terms.back().zext(1));
+    terms = move(next);
+  }
+  return terms[0].zextOrTrunc(nbits);
+}
+
 expr expr::cttz(const expr &val_zero) const {
   C();
+  auto nbits = bits();
   auto srt = sort();
+
+  switch (get_bitcount_encoding()) {
+  case BitCountEncoding::Linear:
+    break;
+
+  case BitCountEncoding::Tree: {
+    // the marker bit makes the input non-zero and gives nbits for zero
+    auto padding = next_pow2(nbits + 1) - nbits;
+    auto cnt
+      = ctlz_bsearch(mkUInt(1, padding).concat(*this).bitreverse(), nbits);
+    return val_zero.eq(mkUInt(nbits, srt)) ? cnt
+                                           : mkIf(*this == 0, val_zero, cnt);
+  }
+
+  case BitCountEncoding::SWAR: {
+    // popcount of the trailing zeros turned into ones; nbits for zero
+    auto cnt = ctpop_swar(~*this & (*this - mkUInt(1, srt)));
+    return val_zero.eq(mkUInt(nbits, srt)) ? cnt
+                                           : mkIf(*this == 0, val_zero, cnt);
+  }
+  }
+
   auto cond = val_zero;
-  for (int i = bits() - 1; i >= 0; --i) {
+  for (int i = nbits - 1; i >= 0; --i) {
     cond = mkIf(extract(i, i) == 1u, mkUInt(i, srt), cond);
   }
 
@@ -855,6 +958,26 @@ expr expr::ctlz() const {
   auto nbits = bits();
   auto srt = sort();
 
+  switch (get_bitcount_encoding()) {
+  case BitCountEncoding::Linear:
+    break;
+
+  case BitCountEncoding::Tree: {
+    // the marker bit makes the input non-zero and gives nbits for zero
+    auto padding = next_pow2(nbits + 1) - nbits;
+    return ctlz_bsearch(concat(mkUInt(1, 1).concat_zeros(padding - 1)), nbits);
+  }
+
+  case BitCountEncoding::SWAR: {
+    // smear the leading one to the right; the leading zeros remain
+    auto v = *this;
+    for (unsigned k = 1; k < nbits; k *= 2) {
+      v = v | v.lshr(mkUInt(k, srt));
+    }
+    return mkUInt(nbits, srt) - ctpop_swar(v);
+  }
+  }
+
   auto cond = mkUInt(nbits, srt);
   for (unsigned i = 0; i < nbits; ++i) {
     cond = mkIf(extract(i, i) == 1u, mkUInt(nbits - 1 - i, srt), cond);
@@ -867,6 +990,15 @@ expr expr::ctpop() const {
   C();
   auto nbits = bits();
 
+  switch (get_bitcount_encoding()) {
+  case BitCountEncoding::Linear:
+    break;
+  case BitCountEncoding::Tree:
+    return ctpop_tree(*this);
+  case BitCountEncoding::SWAR:
+    return ctpop_swar(*this);
+  }
+
   auto res = mkUInt(0, sort());
   for (unsigned i = 0; i < nbits; ++i) {
     res = res + extract(i, i).zext(nbits - 1);
@@ -1595,13 +1727,14 @@ expr expr::load(const expr &idx) const {
       return e.subst(var, idx);
     };
 
+    auto sort = Z3_get_quantifier_bound_sort(ctx(), ast(), 0);
+    expr var = expr::mkQuantVar(0, sort);
     expr cond, then, els;
     if (body.isIf(cond, then, els)) {
-      auto sort = Z3_get_quantifier_bound_sort(ctx(), ast(), 0);
-      expr var = expr::mkQuantVar(0, sort);
       cond = cond.subst(var, idx).simplify();
       return mkIf_fold(cond, subst(then, var), subst(els, var));
     }
+    return subst(body, var);
   }
 
   return Z3_mk_select(ctx(), ast(), idx());
@@ -1758,6 +1891,297 @@ set<expr> expr::vars(const vector<const expr*> &exprs) {
   return result;
 }
 
+pair<unsigned, vector<unsigned>>
+expr::subtermStats(const vector<expr> &vars) const {
+  C();
+  unordered_map<Z3_ast, unsigned> var_idx;
+  for (unsigned i = 0, e = vars.size(); i != e; ++i) {
+    var_idx.emplace(vars[i].ast(), i);
+  }
+
+  auto children = [](Z3_ast ast, vector<Z3_ast> &out) {
+    out.clear();
+    switch (Z3_get_ast_kind(ctx(), ast)) {
+    case Z3_QUANTIFIER_AST:
+      out.emplace_back(Z3_get_quantifier_body(ctx(), ast));
+      break;
+    case Z3_APP_AST:
+      if (!Z3_is_numeral_ast(ctx(), ast)) {
+        auto app = Z3_to_app(ctx(), ast);
+        for (unsigned i = 0, e = Z3_get_app_num_args(ctx(), app); i != e; ++i){
+          out.emplace_back(Z3_get_app_arg(ctx(), app, i));
+        }
+      }
+      break;
+    default:
+      break;
+    }
+  };
+
+  // ast -> bitmask of the vars it depends on
+  unsigned words = (vars.size() + 63) / 64;
+  unordered_map<Z3_ast, vector<uint64_t>> deps;
+  vector<pair<Z3_ast, bool>> todo{ { ast(), false } };
+  vector<Z3_ast> args;
+
+  while (!todo.empty()) {
+    auto [ast, children_done] = todo.back();
+    todo.pop_back();
+    if (deps.count(ast))
+      continue;
+
+    children(ast, args);
+    if (!children_done) {
+      todo.emplace_back(ast, true);
+      for (auto arg : args) {
+        if (!deps.count(arg))
+          todo.emplace_back(arg, false);
+      }
+      continue;
+    }
+
+    vector<uint64_t> mask(words);
+    if (auto I = var_idx.find(ast); I != var_idx.end())
+      mask[I->second / 64] |= 1ull << (I->second % 64);
+    for (auto arg : args) {
+      auto &arg_mask = deps.at(arg);
+      for (unsigned i = 0; i != words; ++i) {
+        mask[i] |= arg_mask[i];
+      }
+    }
+    deps.emplace(ast, move(mask));
+  }
+
+  vector<unsigned> count(vars.size());
+  for (auto &[ast, mask] : deps) {
+    for (unsigned i = 0, e = vars.size(); i != e; ++i) {
+      count[i] += (mask[i / 64] >> (i % 64)) & 1;
+    }
+  }
+  return { deps.size(), move(count) };
+}
+
+// Subterms are only matched modulo normalization if a has at most this many
+// distinct subterms, as each normalization simplifies a whole subterm
+static constexpr unsigned max_normalized_subterms = 2048;
+
+vector<pair<expr, expr>>
+expr::commonSubterms(const vector<const expr*> &a,
+                     const vector<const expr*> &b,
+                     const set<expr> &excluded_vars) {
+  auto num_args = [](Z3_ast ast) -> unsigned {
+    if (Z3_get_ast_kind(ctx(), ast) != Z3_APP_AST ||
+        Z3_is_numeral_ast(ctx(), ast))
+      return 0;
+    return Z3_get_app_num_args(ctx(), Z3_to_app(ctx(), ast));
+  };
+  auto arg = [](Z3_ast ast, unsigned i) {
+    return Z3_get_app_arg(ctx(), Z3_to_app(ctx(), ast), i);
+  };
+
+  // all applications in a; quantifiers are not traversed
+  unordered_set<Z3_ast> in_a;
+  vector<Z3_ast> todo;
+  for (auto e : a) {
+    if (e->isValid() && in_a.emplace(e->ast()).second)
+      todo.emplace_back(e->ast());
+  }
+  while (!todo.empty()) {
+    auto ast = todo.back();
+    todo.pop_back();
+    for (unsigned i = 0, e = num_args(ast); i != e; ++i) {
+      auto child = arg(ast, i);
+      if (in_a.emplace(child).second)
+        todo.emplace_back(child);
+    }
+  }
+
+  // ast -> whether it depends on excluded vars or on bound vars
+  unordered_map<Z3_ast, bool> tainted;
+  auto is_tainted = [&](Z3_ast root) {
+    vector<pair<Z3_ast, bool>> stack{ { root, false } };
+    while (!stack.empty()) {
+      auto [ast, children_done] = stack.back();
+      stack.pop_back();
+      if (tainted.count(ast))
+        continue;
+
+      auto kind = Z3_get_ast_kind(ctx(), ast);
+      if (kind == Z3_VAR_AST || kind == Z3_QUANTIFIER_AST) {
+        tainted.emplace(ast, true);
+        continue;
+      }
+
+      unsigned n = num_args(ast);
+      if (n == 0) {
+        tainted.emplace(ast, kind == Z3_APP_AST &&
+                             !Z3_is_numeral_ast(ctx(), ast) &&
+                             excluded_vars.count(expr(ast)));
+        continue;
+      }
+
+      if (!children_done) {
+        stack.emplace_back(ast, true);
+        for (unsigned i = 0; i != n; ++i) {
+          stack.emplace_back(arg(ast, i), false);
+        }
+        continue;
+      }
+
+      bool t = false;
+      for (unsigned i = 0; i != n && !t; ++i) {
+        t = tainted.at(arg(ast, i));
+      }
+      tainted.emplace(ast, t);
+    }
+    return tainted.at(root);
+  };
+
+  // ast -> normal form: sub and neg are rewritten into add and mul,
+  // associative-commutative operations are flattened and their operands
+  // sorted, and the result is simplified
+  unordered_map<Z3_ast, expr> normal;
+  auto normalize = [&](Z3_ast root) -> const expr& {
+    vector<pair<Z3_ast, bool>> stack{ { root, false } };
+    while (!stack.empty()) {
+      auto [ast, children_done] = stack.back();
+      stack.pop_back();
+      if (normal.count(ast))
+        continue;
+
+      unsigned n = num_args(ast);
+      if (n == 0) {
+        normal.emplace(ast, ast);
+        continue;
+      }
+
+      if (!children_done) {
+        stack.emplace_back(ast, true);
+        for (unsigned i = 0; i != n; ++i) {
+          stack.emplace_back(arg(ast, i), false);
+        }
+        continue;
+      }
+
+      vector<expr> args;
+      for (unsigned i = 0; i != n; ++i) {
+        args.emplace_back(normal.at(arg(ast, i)));
+      }
+
+      auto kind = Z3_get_decl_kind(ctx(),
+                                   Z3_get_app_decl(ctx(), Z3_to_app(ctx(), ast)));
+      if (kind == Z3_OP_BSUB && n == 2) {
+        args[1] = args[1] * mkInt(-1, args[1]);
+        kind = Z3_OP_BADD;
+      } else if (kind == Z3_OP_BNEG) {
+        args.emplace_back(mkInt(-1, args[0]));
+        kind = Z3_OP_BMUL;
+      }
+
+      expr key;
+      switch (kind) {
+      case Z3_OP_BADD:
+      case Z3_OP_BMUL:
+      case Z3_OP_BAND:
+      case Z3_OP_BOR:
+      case Z3_OP_BXOR:
+      case Z3_OP_AND:
+      case Z3_OP_OR: {
+        vector<expr> flat;
+        for (auto &k : args) {
+          if (auto app = k.isAppOf(kind)) {
+            for (unsigned i = 0, e = Z3_get_app_num_args(ctx(), app); i != e;
+                 ++i) {
+              flat.emplace_back(Z3_get_app_arg(ctx(), app, i));
+            }
+          } else {
+            flat.emplace_back(move(k));
+          }
+        }
+        std::sort(flat.begin(), flat.end());
+
+        key = flat[0];
+        for (unsigned i = 1, e = flat.size(); i != e; ++i) {
+          switch (kind) {
+          case Z3_OP_BADD: key = key + flat[i]; break;
+          case Z3_OP_BMUL: key = key * flat[i]; break;
+          case Z3_OP_BAND: key = key & flat[i]; break;
+          case Z3_OP_BOR:  key = key | flat[i]; break;
+          case Z3_OP_BXOR: key = key ^ flat[i]; break;
+          case Z3_OP_AND:  key = key && flat[i]; break;
+          case Z3_OP_OR:   key = key || flat[i]; break;
+          default: UNREACHABLE();
+          }
+        }
+        break;
+      }
+      case Z3_OP_EQ:
+        if (n == 2) {
+          std::sort(args.begin(), args.end());
+          key = args[0] == args[1];
+          break;
+        }
+        [[fallthrough]];
+      default: {
+        vector<Z3_ast> asts;
+        for (auto &k : args) {
+          asts.emplace_back(k());
+        }
+        key = Z3_update_term(ctx(), ast, n, asts.data());
+        break;
+      }
+      }
+      normal.emplace(ast, key.simplify());
+    }
+    return normal.at(root);
+  };
+
+  // normal form -> untainted subterm of a
+  unordered_map<Z3_ast, Z3_ast> a_normal;
+  bool do_normalize = in_a.size() <= max_normalized_subterms;
+  if (do_normalize) {
+    for (auto ast : in_a) {
+      if (num_args(ast) != 0 && !is_tainted(ast))
+        a_normal.emplace(normalize(ast)(), ast);
+    }
+  }
+
+  vector<pair<expr, expr>> result;
+  unordered_set<Z3_ast> seen;
+  for (auto e : b) {
+    if (e->isValid() && seen.emplace(e->ast()).second)
+      todo.emplace_back(e->ast());
+  }
+  while (!todo.empty()) {
+    auto ast = todo.back();
+    todo.pop_back();
+    unsigned n = num_args(ast);
+    if (n == 0)
+      continue;
+
+    if (in_a.count(ast) && !is_tainted(ast)) {
+      result.emplace_back(ast, ast);
+      continue;
+    }
+
+    if (do_normalize && normal.size() <= 2 * max_normalized_subterms &&
+        !is_tainted(ast)) {
+      if (auto I = a_normal.find(normalize(ast)());
+          I != a_normal.end()) {
+        result.emplace_back(I->second, ast);
+        continue;
+      }
+    }
+
+    for (unsigned i = 0; i != n; ++i) {
+      auto child = arg(ast, i);
+      if (seen.emplace(child).second)
+        todo.emplace_back(child);
+    }
+  }
+  return result;
+}
+
 void expr::printUnsigned(ostream &os) const {
   os << numeral_string();
 }
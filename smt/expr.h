@@ -109,6 +109,7 @@ public:
 
   // structural equivalence
   bool eq(const expr &rhs) const;
+  bool isSameSort(const expr &rhs) const;
 
   bool isValid() const { return ptr != 0; }
 
@@ -139,6 +140,7 @@ public:
   bool isAnd(expr &a, expr &b) const;
   bool isNot(expr &neg) const;
   bool isAdd(expr &a, expr &b) const;
+  bool isMul(expr &a, expr &b) const;
   bool isBasePlusOffset(expr &base, uint64_t &offset) const;
   bool isConstArray(expr &val) const;
   bool isStore(expr &array, expr &idx, expr &val) const;
@@ -319,6 +321,20 @@ public:
   std::set<expr> vars() const;
   static std::set<expr> vars(const std::vector<const expr*> &exprs);
 
+  // Returns the number of distinct subterms, and for each of the given vars
+  // the number of those subterms that depend on it
+  std::pair<unsigned, std::vector<unsigned>>
+    subtermStats(const std::vector<expr> &vars) const;
+
+  // Returns the maximal subterms of b that are equal to subterms of a, paired
+  // with the latter, excluding variables, constants, and terms that depend on
+  // any of the given vars. Subterms are compared after normalizing add/sub/mul
+  // chains and the order of operands of commutative operations.
+  static std::vector<std::pair<expr, expr>>
+    commonSubterms(const std::vector<const expr*> &a,
+                   const std::vector<const expr*> &b,
+                   const std::set<expr> &excluded_vars);
+
   void printUnsigned(std::ostream &os) const;
   void printSigned(std::ostream &os) const;
   void printHexadecimal(std::ostream &os) const;
@@ -340,6 +356,7 @@ public:
   static bool allValid() { return true; }
 
   friend class Solver;
+  friend class SolverBackend;
   friend class Model;
   friend class ExprLeafIterator;
 };
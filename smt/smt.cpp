@@ -60,6 +60,17 @@ const char *get_random_seed() {
 }
 
 
+static BitCountEncoding bitcount_enc = BitCountEncoding::Tree;
+
+void set_bitcount_encoding(BitCountEncoding enc) {
+  bitcount_enc = enc;
+}
+
+BitCountEncoding get_bitcount_encoding() {
+  return bitcount_enc;
+}
+
+
 static uint64_t z3_memory_limit = 1ull << 30; // 1 GB
 
 void set_memory_limit(uint64_t limit) {
@@ -23,6 +23,12 @@ const char* get_query_timeout();
 void set_random_seed(std::string seed);
 const char *get_random_seed();
 
+// how ctpop/ctlz/cttz are encoded: a linear chain of ites/adds, a log-depth
+// adder tree/binary search, or the SWAR formulation (masked adds & shifts)
+enum class BitCountEncoding { Linear, Tree, SWAR };
+void set_bitcount_encoding(BitCountEncoding enc);
+BitCountEncoding get_bitcount_encoding();
+
 void set_memory_limit(uint64_t limit);
 bool hit_memory_limit();
 bool hit_half_memory_limit();
@@ -2,13 +2,26 @@
 // Distributed under the MIT license that can be found in the LICENSE file.
 
 #include "smt/solver.h"
+#include "smt/aig.h"
 #include "smt/ctx.h"
+#include "smt/smt.h"
 #include "util/compiler.h"
 #include "util/config.h"
 #include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <optional>
+#include <poll.h>
+#include <pthread.h>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 #include <z3.h>
@@ -27,6 +40,7 @@ static unsigned num_sats = 0;
 static unsigned num_unsats = 0;
 static unsigned num_timeout = 0;
 static unsigned num_errors = 0;
+static unsigned num_external = 0;
 
 namespace {
 class Tactic {
@@ -150,6 +164,350 @@ public:
 static optional<MultiTactic> tactic;
 
 
+namespace {
+class Z3Backend final : public SolverBackend {
+public:
+  Result check(Z3_solver s, unsigned) override {
+    return toResult(s, Z3_solver_check(ctx(), s));
+  }
+
+  static Result toResult(Z3_solver s, Z3_lbool r) {
+    switch (r) {
+    case Z3_L_FALSE:
+      return mkResult(Result::UNSAT);
+    case Z3_L_TRUE:
+      return mkSat(Z3_solver_get_model(ctx(), s));
+    case Z3_L_UNDEF: {
+      string reason = Z3_solver_get_reason_unknown(ctx(), s);
+      if (reason == "timeout")
+        return mkResult(Result::TIMEOUT);
+      return mkResult(Result::ERROR, move(reason));
+    }
+    default:
+      UNREACHABLE();
+    }
+  }
+};
+
+
+// returns [begin, end) of the s-expression that starts at or after pos
+static pair<size_t, size_t> next_sexpr(string_view str, size_t pos) {
+  while (pos < str.size() && isspace(str[pos]))
+    ++pos;
+  size_t begin = pos;
+  unsigned depth = 0;
+
+  for (; pos < str.size(); ++pos) {
+    char c = str[pos];
+    if (c == '|' || c == '"') {
+      pos = str.find(c, pos + 1);
+      if (pos == string_view::npos)
+        return { begin, str.size() };
+    } else if (c == '(') {
+      ++depth;
+    } else if (c == ')') {
+      if (depth == 0)
+        break;
+      if (--depth == 0)
+        return { begin, pos + 1 };
+    } else if (depth == 0 && isspace(c)) {
+      break;
+    }
+  }
+  return { begin, pos };
+}
+
+// iterate over the elements of list str, calling fn for each
+template <typename Fn>
+static void for_each_elem(string_view str, Fn &&fn) {
+  if (str.size() < 2 || str.front() != '(')
+    return;
+  str = str.substr(1, str.size() - 2);
+  size_t pos = 0;
+  while (true) {
+    auto [b, e] = next_sexpr(str, pos);
+    if (b == e)
+      break;
+    fn(str.substr(b, e - b));
+    pos = e;
+  }
+}
+
+static expr parse_bv_digits(string_view digits, unsigned radix_bits) {
+  // up to 64 bits per chunk
+  unsigned chunk_digits = 64 / radix_bits;
+  expr res;
+  for (size_t i = 0; i < digits.size(); i += chunk_digits) {
+    auto chunk = string(digits.substr(i, chunk_digits));
+    auto val = expr::mkUInt(strtoull(chunk.c_str(), nullptr, 1u << radix_bits),
+                            chunk.size() * radix_bits);
+    res = res.isValid() ? res.concat(val) : val;
+  }
+  return res;
+}
+
+// parse a value of a model: booleans and bit-vector literals only
+static expr parse_value(string_view val) {
+  if (val == "true")
+    return true;
+  if (val == "false")
+    return false;
+  if (val.size() > 2 && val.substr(0, 2) == "#b")
+    return parse_bv_digits(val.substr(2), 1);
+  if (val.size() > 2 && val.substr(0, 2) == "#x")
+    return parse_bv_digits(val.substr(2), 4);
+
+  // (_ bvN W)
+  vector<string_view> elems;
+  for_each_elem(val, [&](string_view e) { elems.emplace_back(e); });
+  if (elems.size() == 3 && elems[0] == "_" && elems[1].substr(0, 2) == "bv")
+    return expr::mkInt(string(elems[1].substr(2)).c_str(),
+                       stoul(string(elems[2])));
+  return {};
+}
+
+
+// Runs a solver executable per query, feeding it SMT-LIB2 through a pipe.
+// Models are read back and completed by Z3, such that the rest of the
+// pipeline can keep using Z3 models.
+class ExternalBackend final : public SolverBackend {
+  string cmd;
+  const char *logic;
+  Z3Backend fallback;
+
+  // returns false on timeout
+  bool run(const string &input, string &output, unsigned timeout_ms) {
+    int in[2], out[2];
+    if (pipe(in) != 0)
+      return true;
+    if (pipe(out) != 0) {
+      close(in[0]);
+      close(in[1]);
+      return true;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      // own process group, such that a timeout kills the whole pipeline
+      setpgid(0, 0);
+      dup2(in[0], STDIN_FILENO);
+      dup2(out[1], STDOUT_FILENO);
+      close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+      execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*)nullptr);
+      _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+
+    if (pid < 0) {
+      close(in[1]);
+      close(out[0]);
+      return true;
+    }
+
+    // The solver may start answering before it has read the whole query, so
+    // feed it and drain its output in the same loop. Otherwise both sides
+    // can block on a full pipe.
+    fcntl(in[1], F_SETFL, fcntl(in[1], F_GETFL) | O_NONBLOCK);
+
+    // A dying solver shouldn't kill us while we're writing the query.
+    // Block SIGPIPE in this thread only, and discard the signal if a write
+    // raised it, so the process' disposition is left untouched.
+    sigset_t pipe_set, old_set, pending;
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+    sigpending(&pending);
+    bool was_pending = sigismember(&pending, SIGPIPE);
+    bool broken_pipe = false;
+
+    bool timeout = false;
+    auto deadline = chrono::steady_clock::now() +
+                    chrono::milliseconds(timeout_ms);
+    size_t written = 0;
+    char buf[4096];
+    while (true) {
+      auto left = chrono::duration_cast<chrono::milliseconds>(
+                    deadline - chrono::steady_clock::now()).count();
+      pollfd fds[2] = { { out[0], POLLIN, 0 }, { in[1], POLLOUT, 0 } };
+      int r = left <= 0 ? 0 : poll(fds, in[1] >= 0 ? 2 : 1, left);
+      if (r < 0 && errno == EINTR)
+        continue;
+      if (r <= 0) {
+        timeout = r == 0;
+        kill(-pid, SIGKILL);
+        break;
+      }
+
+      if (in[1] >= 0 && fds[1].revents) {
+        auto n = write(in[1], input.data() + written, input.size() - written);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+          continue;
+        if (n > 0)
+          written += n;
+        else
+          broken_pipe = n < 0 && errno == EPIPE;
+        if (n <= 0 || written == input.size()) {
+          close(in[1]);
+          in[1] = -1;
+        }
+      }
+
+      if (fds[0].revents) {
+        auto n = read(out[0], buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n <= 0)
+          break;
+        output.append(buf, n);
+      }
+    }
+    if (in[1] >= 0)
+      close(in[1]);
+    close(out[0]);
+
+    if (broken_pipe && !was_pending) {
+      timespec zero = { 0, 0 };
+      while (sigtimedwait(&pipe_set, nullptr, &zero) < 0 && errno == EINTR);
+    }
+    pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+
+    waitpid(pid, nullptr, 0);
+    return !timeout;
+  }
+
+public:
+  ExternalBackend(string &&cmd, const char *logic)
+    : cmd(move(cmd)), logic(logic) {}
+
+  Result check(Z3_solver s, unsigned timeout_ms) override {
+    string query = "(set-option :produce-models true)\n";
+    if (logic)
+      query += string("(set-logic ") + logic + ")\n";
+    query += Z3_solver_to_string(ctx(), s);
+    query += "(check-sat)\n(get-model)\n(exit)\n";
+
+    string output;
+    if (!run(query, output, timeout_ms))
+      return mkResult(Result::TIMEOUT);
+
+    string_view out = output;
+    auto [b, e] = next_sexpr(out, 0);
+    auto answer = out.substr(b, e - b);
+
+    if (answer == "unsat")
+      return mkResult(Result::UNSAT);
+    if (answer == "unknown")
+      return mkResult(Result::ERROR, "external solver returned unknown");
+    if (answer != "sat")
+      return mkResult(Result::ERROR,
+                      "external solver error: " + string(out.substr(0, 200)));
+
+    // Read the model and let Z3 complete it, as the external solver may
+    // omit variables or use values we don't parse
+    auto [mb, me] = next_sexpr(out, e);
+    vector<expr> model;
+    for_each_elem(out.substr(mb, me - mb), [&](string_view def) {
+      // (define-fun name () sort value)
+      vector<string_view> elems;
+      for_each_elem(def, [&](string_view e) { elems.emplace_back(e); });
+      if (elems.size() != 5 || elems[0] != "define-fun" || elems[2] != "()")
+        return;
+
+      auto name = elems[1];
+      if (name.size() > 1 && name.front() == '|')
+        name = name.substr(1, name.size() - 2);
+
+      auto val = parse_value(elems[4]);
+      if (!val.isValid())
+        return;
+      string str(name);
+      auto var = val.isBool() ? expr::mkBoolVar(str.c_str())
+                              : expr::mkVar(str.c_str(), val.bits());
+      model.emplace_back(var == val);
+    });
+
+    auto r = completeModel(s, model);
+    if (r.isSat())
+      return r;
+
+    // the model didn't work out; ask Z3 to solve the query from scratch
+    return fallback.check(s, timeout_ms);
+  }
+};
+
+
+class AIGBackend final : public SolverBackend {
+  bool sweep;
+  Z3Backend fallback;
+
+public:
+  AIGBackend(bool sweep) : sweep(sweep) {}
+
+  Result check(Z3_solver s, unsigned timeout_ms) override {
+    auto vect = Z3_solver_get_assertions(ctx(), s);
+    Z3_ast_vector_inc_ref(ctx(), vect);
+    vector<Z3_ast> assertions;
+    for (unsigned i = 0, e = Z3_ast_vector_size(ctx(), vect); i != e; ++i) {
+      assertions.emplace_back(Z3_ast_vector_get(ctx(), vect, i));
+    }
+
+    vector<expr> model;
+    auto answer = aig_check(assertions, sweep, timeout_ms, model);
+    Z3_ast_vector_dec_ref(ctx(), vect);
+
+    switch (answer) {
+    case AIGAnswer::UNSAT:
+      return mkResult(Result::UNSAT);
+    case AIGAnswer::UNKNOWN:
+      return mkResult(Result::TIMEOUT);
+    case AIGAnswer::SAT: {
+      auto r = completeModel(s, model);
+      if (r.isSat())
+        return r;
+      break;
+    }
+    case AIGAnswer::UNSUPPORTED:
+      break;
+    }
+    return fallback.check(s, timeout_ms);
+  }
+};
+}
+
+static Z3Backend z3_backend;
+static unique_ptr<SolverBackend> external_backends[2];
+static unique_ptr<SolverBackend> aig_backend;
+
+static SolverBackend& get_backend(Z3_solver s) {
+  auto &qfbv = external_backends[(unsigned)QueryClass::QF_BV];
+  auto &other = external_backends[(unsigned)QueryClass::Other];
+  if (!qfbv && !other && !aig_backend)
+    return z3_backend;
+
+  auto goal = Z3_mk_goal(ctx(), false, false, false);
+  Z3_goal_inc_ref(ctx(), goal);
+  auto assertions = Z3_solver_get_assertions(ctx(), s);
+  Z3_ast_vector_inc_ref(ctx(), assertions);
+  for (unsigned i = 0, e = Z3_ast_vector_size(ctx(), assertions); i != e; ++i) {
+    Z3_goal_assert(ctx(), goal, Z3_ast_vector_get(ctx(), assertions, i));
+  }
+  Z3_ast_vector_dec_ref(ctx(), assertions);
+
+  auto probe = Z3_mk_probe(ctx(), "is-qfbv");
+  Z3_probe_inc_ref(ctx(), probe);
+  bool is_qfbv = Z3_probe_apply(ctx(), probe, goal) != 0.0;
+  Z3_probe_dec_ref(ctx(), probe);
+  Z3_goal_dec_ref(ctx(), goal);
+
+  if (is_qfbv && !qfbv && aig_backend)
+    return *aig_backend;
+
+  auto &backend = is_qfbv ? qfbv : other;
+  return backend ? *backend : z3_backend;
+}
+
+
 namespace smt {
 
 Model::Model(Z3_model m) : m(m) {
@@ -162,12 +520,336 @@ Model::~Model() {
 }
 
 void Model::operator=(Model &&other) {
-  this->~Model();
+  if (m)
+    Z3_model_dec_ref(ctx(), m);
   m = 0;
+  eval_cache.clear();
   swap(other.m, m);
+  swap(other.eval_cache, eval_cache);
+}
+
+static uint64_t trunc(uint64_t n, unsigned bits) {
+  return bits >= 64 ? n : n & ((UINT64_C(1) << bits) - 1);
+}
+
+static bool is_neg(uint64_t n, unsigned bits) {
+  return (n >> (bits - 1)) & 1;
+}
+
+static uint64_t neg(uint64_t n, unsigned bits) {
+  return trunc(-n, bits);
+}
+
+static optional<uint64_t> numeral_val(Z3_ast a) {
+  switch (Z3_get_bool_value(ctx(), a)) {
+  case Z3_L_TRUE:  return 1;
+  case Z3_L_FALSE: return 0;
+  case Z3_L_UNDEF: break;
+  }
+  uint64_t n;
+  if (Z3_get_ast_kind(ctx(), a) == Z3_NUMERAL_AST &&
+      Z3_get_numeral_uint64(ctx(), a, &n))
+    return n;
+  return {};
+}
+
+optional<uint64_t> Model::evalZ3(Z3_ast a) const {
+  // without model completion, so the value doesn't depend on it
+  Z3_ast val;
+  if (!Z3_model_eval(ctx(), m, a, false, &val))
+    return {};
+  expr e(val);
+  return numeral_val(e());
+}
+
+optional<uint64_t> Model::evalNative(Z3_ast a) const {
+  unsigned id = Z3_get_ast_id(ctx(), a);
+  if (auto I = eval_cache.find(id); I != eval_cache.end())
+    return I->second.second;
+
+  auto res = [&]() -> optional<uint64_t> {
+    auto sort = Z3_get_sort(ctx(), a);
+    unsigned width = 1;
+    switch (Z3_get_sort_kind(ctx(), sort)) {
+    case Z3_BOOL_SORT:
+      break;
+    case Z3_BV_SORT:
+      width = Z3_get_bv_sort_size(ctx(), sort);
+      if (width > 64)
+        return {};
+      break;
+    default:
+      return {};
+    }
+
+    if (Z3_get_ast_kind(ctx(), a) == Z3_NUMERAL_AST)
+      return numeral_val(a);
+    if (Z3_get_ast_kind(ctx(), a) != Z3_APP_AST)
+      return evalZ3(a);
+
+    auto app = Z3_to_app(ctx(), a);
+    auto decl = Z3_get_app_decl(ctx(), app);
+    unsigned num_args = Z3_get_app_num_args(ctx(), app);
+    auto arg_ast = [&](unsigned i) { return Z3_get_app_arg(ctx(), app, i); };
+    auto arg_bits = [&](unsigned i) {
+      auto sort = Z3_get_sort(ctx(), arg_ast(i));
+      return Z3_get_sort_kind(ctx(), sort) == Z3_BV_SORT
+               ? Z3_get_bv_sort_size(ctx(), sort) : 1;
+    };
+    auto param = [&](unsigned i) {
+      return (unsigned)Z3_get_decl_int_parameter(ctx(), decl, i);
+    };
+
+    // evaluate all arguments, falling back to Z3 for the whole term if any
+    // is not supported
+    vector<uint64_t> args;
+    auto eval_args = [&]() {
+      for (unsigned i = 0; i != num_args; ++i) {
+        auto v = evalNative(arg_ast(i));
+        if (!v)
+          return false;
+        args.emplace_back(*v);
+      }
+      return true;
+    };
+    auto fold = [&](auto op) -> optional<uint64_t> {
+      if (!eval_args())
+        return evalZ3(a);
+      uint64_t r = args[0];
+      for (unsigned i = 1; i != num_args; ++i) {
+        r = op(r, args[i]);
+      }
+      return trunc(r, width);
+    };
+    auto cmp = [&](auto op, bool is_signed) -> optional<uint64_t> {
+      if (!eval_args())
+        return evalZ3(a);
+      uint64_t x = args[0], y = args[1];
+      if (is_signed) {
+        // flip the sign bit to compare as unsigned
+        auto sign = UINT64_C(1) << (arg_bits(0) - 1);
+        x ^= sign;
+        y ^= sign;
+      }
+      return op(x, y);
+    };
+
+    switch (Z3_get_decl_kind(ctx(), decl)) {
+    case Z3_OP_TRUE:
+    case Z3_OP_BIT1:
+      return 1;
+    case Z3_OP_FALSE:
+    case Z3_OP_BIT0:
+      return 0;
+
+    case Z3_OP_UNINTERPRETED: {
+      if (num_args != 0)
+        return evalZ3(a);
+      // the native assignment table is the model itself; constants without
+      // an interpretation are left unknown
+      auto val = Z3_model_get_const_interp(ctx(), m, decl);
+      if (!val)
+        return {};
+      expr e(val);
+      return numeral_val(e());
+    }
+
+    // short-circuit so that only the relevant subterms are evaluated
+    case Z3_OP_ITE: {
+      auto c = evalNative(arg_ast(0));
+      if (!c)
+        return evalZ3(a);
+      return evalNative(arg_ast(*c ? 1 : 2));
+    }
+    case Z3_OP_AND:
+    case Z3_OP_OR: {
+      bool is_and = Z3_get_decl_kind(ctx(), decl) == Z3_OP_AND;
+      bool unknown = false;
+      for (unsigned i = 0; i != num_args; ++i) {
+        auto v = evalNative(arg_ast(i));
+        if (!v)
+          unknown = true;
+        else if (*v != is_and)
+          return !is_and;
+      }
+      if (unknown)
+        return evalZ3(a);
+      return is_and;
+    }
+
+    case Z3_OP_EQ:
+    case Z3_OP_IFF:
+    case Z3_OP_BCOMP:
+      return fold([](uint64_t x, uint64_t y) { return x == y; });
+    case Z3_OP_DISTINCT: {
+      if (!eval_args())
+        return evalZ3(a);
+      for (unsigned i = 0; i != num_args; ++i) {
+        for (unsigned j = i + 1; j != num_args; ++j) {
+          if (args[i] == args[j])
+            return 0;
+        }
+      }
+      return 1;
+    }
+    case Z3_OP_XOR:
+    case Z3_OP_BXOR:
+      return fold([](uint64_t x, uint64_t y) { return x ^ y; });
+    case Z3_OP_NOT:
+    case Z3_OP_BNOT:
+      if (!eval_args())
+        return evalZ3(a);
+      return trunc(~args[0], width);
+    case Z3_OP_IMPLIES:
+      return fold([](uint64_t x, uint64_t y) { return !x || y; });
+    case Z3_OP_BAND:
+      return fold([](uint64_t x, uint64_t y) { return x & y; });
+    case Z3_OP_BOR:
+      return fold([](uint64_t x, uint64_t y) { return x | y; });
+    case Z3_OP_BNAND:
+      return fold([](uint64_t x, uint64_t y) { return ~(x & y); });
+    case Z3_OP_BNOR:
+      return fold([](uint64_t x, uint64_t y) { return ~(x | y); });
+    case Z3_OP_BXNOR:
+      return fold([](uint64_t x, uint64_t y) { return ~(x ^ y); });
+
+    case Z3_OP_BNEG:
+      if (!eval_args())
+        return evalZ3(a);
+      return neg(args[0], width);
+    case Z3_OP_BADD:
+      return fold([](uint64_t x, uint64_t y) { return x + y; });
+    case Z3_OP_BSUB:
+      return fold([](uint64_t x, uint64_t y) { return x - y; });
+    case Z3_OP_BMUL:
+      return fold([](uint64_t x, uint64_t y) { return x * y; });
+
+    case Z3_OP_BUDIV:
+    case Z3_OP_BUDIV_I:
+    case Z3_OP_BUREM:
+    case Z3_OP_BUREM_I:
+    case Z3_OP_BSDIV:
+    case Z3_OP_BSDIV_I:
+    case Z3_OP_BSREM:
+    case Z3_OP_BSREM_I:
+    case Z3_OP_BSMOD:
+    case Z3_OP_BSMOD_I: {
+      // division by zero is left to Z3
+      if (!eval_args() || args[1] == 0)
+        return evalZ3(a);
+      uint64_t x = args[0], y = args[1];
+      bool sx = is_neg(x, width), sy = is_neg(y, width);
+      switch (Z3_get_decl_kind(ctx(), decl)) {
+      case Z3_OP_BUDIV:
+      case Z3_OP_BUDIV_I:
+        return x / y;
+      case Z3_OP_BUREM:
+      case Z3_OP_BUREM_I:
+        return x % y;
+      default:
+        break;
+      }
+      uint64_t ax = sx ? neg(x, width) : x;
+      uint64_t ay = sy ? neg(y, width) : y;
+      uint64_t q = ax / ay, r = ax % ay;
+      switch (Z3_get_decl_kind(ctx(), decl)) {
+      case Z3_OP_BSDIV:
+      case Z3_OP_BSDIV_I:
+        return sx != sy ? neg(q, width) : q;
+      case Z3_OP_BSREM:
+      case Z3_OP_BSREM_I:
+        return sx ? neg(r, width) : r;
+      default:
+        if (r == 0)
+          return 0;
+        if (sx == sy)
+          return sx ? neg(r, width) : r;
+        return trunc(sx ? y - r : y + r, width);
+      }
+    }
+
+    case Z3_OP_ULEQ:
+      return cmp([](uint64_t x, uint64_t y) { return x <= y; }, false);
+    case Z3_OP_SLEQ:
+      return cmp([](uint64_t x, uint64_t y) { return x <= y; }, true);
+    case Z3_OP_UGEQ:
+      return cmp([](uint64_t x, uint64_t y) { return x >= y; }, false);
+    case Z3_OP_SGEQ:
+      return cmp([](uint64_t x, uint64_t y) { return x >= y; }, true);
+    case Z3_OP_ULT:
+      return cmp([](uint64_t x, uint64_t y) { return x < y; }, false);
+    case Z3_OP_SLT:
+      return cmp([](uint64_t x, uint64_t y) { return x < y; }, true);
+    case Z3_OP_UGT:
+      return cmp([](uint64_t x, uint64_t y) { return x > y; }, false);
+    case Z3_OP_SGT:
+      return cmp([](uint64_t x, uint64_t y) { return x > y; }, true);
+
+    case Z3_OP_CONCAT: {
+      if (!eval_args())
+        return evalZ3(a);
+      uint64_t r = 0;
+      for (unsigned i = 0; i != num_args; ++i) {
+        auto bits = arg_bits(i);
+        r = (bits >= 64 ? 0 : r << bits) | args[i];
+      }
+      return r;
+    }
+    case Z3_OP_EXTRACT:
+      if (!eval_args())
+        return evalZ3(a);
+      return trunc(args[0] >> param(1), width);
+    case Z3_OP_ZERO_EXT:
+      if (!eval_args())
+        return evalZ3(a);
+      return args[0];
+    case Z3_OP_SIGN_EXT: {
+      if (!eval_args())
+        return evalZ3(a);
+      auto bits = arg_bits(0);
+      uint64_t x = args[0];
+      if (is_neg(x, bits))
+        x |= ~trunc(~UINT64_C(0), bits);
+      return trunc(x, width);
+    }
+    case Z3_OP_BSHL:
+    case Z3_OP_BLSHR:
+    case Z3_OP_BASHR: {
+      if (!eval_args())
+        return evalZ3(a);
+      uint64_t x = args[0], amt = args[1];
+      bool sign = is_neg(x, width);
+      switch (Z3_get_decl_kind(ctx(), decl)) {
+      case Z3_OP_BSHL:
+        return amt >= width ? 0 : trunc(x << amt, width);
+      case Z3_OP_BLSHR:
+        return amt >= width ? 0 : x >> amt;
+      default:
+        if (amt >= width)
+          return sign ? trunc(~UINT64_C(0), width) : 0;
+        x >>= amt;
+        if (sign)
+          x |= ~trunc(~UINT64_C(0), width - amt);
+        return trunc(x, width);
+      }
+    }
+
+    default:
+      return evalZ3(a);
+    }
+  }();
+
+  eval_cache.emplace(id, make_pair(expr(a), res));
+  return res;
 }
 
 expr Model::eval(const expr &var, bool complete) const {
+  if (auto v = evalNative(var())) {
+    if (var.isBool())
+      return *v != 0;
+    return expr::mkUInt(*v, var.bits());
+  }
+
   Z3_ast val;
   ENSURE(Z3_model_eval(ctx(), m, var(), complete, &val));
   return val;
@@ -203,6 +885,31 @@ ostream& operator<<(ostream &os, const Model &m) {
 }
 
 
+void SolverBackend::add(Z3_solver s, const expr &e) {
+  Z3_solver_assert(ctx(), s, e());
+}
+
+Result SolverBackend::completeModel(Z3_solver s, const vector<expr> &model) {
+  Z3_solver ms = Z3_mk_simple_solver(ctx());
+  Z3_solver_inc_ref(ctx(), ms);
+
+  auto assertions = Z3_solver_get_assertions(ctx(), s);
+  Z3_ast_vector_inc_ref(ctx(), assertions);
+  for (unsigned i = 0, e = Z3_ast_vector_size(ctx(), assertions); i != e; ++i) {
+    Z3_solver_assert(ctx(), ms, Z3_ast_vector_get(ctx(), assertions, i));
+  }
+  Z3_ast_vector_dec_ref(ctx(), assertions);
+
+  for (auto &e : model) {
+    add(ms, e);
+  }
+
+  auto r = z3_backend.check(ms, 0);
+  Z3_solver_dec_ref(ctx(), ms);
+  return r;
+}
+
+
 SolverPush::SolverPush(Solver &s) : s(s) {
   Z3_solver_push(ctx(), s.s);
 }
@@ -242,6 +949,15 @@ void Solver::add(const expr &e) {
   }
 }
 
+void Solver::setTimeout(unsigned ms) {
+  timeout_ms = ms;
+  auto p = Z3_mk_params(ctx());
+  Z3_params_inc_ref(ctx(), p);
+  Z3_params_set_uint(ctx(), p, Z3_mk_string_symbol(ctx(), "timeout"), ms);
+  Z3_solver_set_params(ctx(), s, p);
+  Z3_params_dec_ref(ctx(), p);
+}
+
 void Solver::block(const Model &m, Solver *sneg) {
   set<expr> assignments;
   for (const auto &[var, val] : m) {
@@ -299,29 +1015,54 @@ Result Solver::check() const {
 
   tactic->check();
 
-  switch (Z3_solver_check(ctx(), s)) {
-  case Z3_L_FALSE:
-    ++num_unsats;
-    return Result::UNSAT;
-  case Z3_L_TRUE:
-    ++num_sats;
-    return Z3_solver_get_model(ctx(), s);
-  case Z3_L_UNDEF: {
-    string reason = Z3_solver_get_reason_unknown(ctx(), s);
-    if (reason == "timeout") {
-      ++num_timeout;
-      return Result::TIMEOUT;
-    }
-    ++num_errors;
-    return { Result::ERROR, move(reason) };
-  }
+  auto &backend = get_backend(s);
+  if (&backend != &z3_backend && &backend != aig_backend.get())
+    ++num_external;
+
+  auto r = backend.check(s, timeout_ms ? timeout_ms
+                                       : strtoul(get_query_timeout(),
+                                                 nullptr, 10));
+  switch (r.a) {
+  case Result::UNSAT:   ++num_unsats; break;
+  case Result::SAT:     ++num_sats; break;
+  case Result::TIMEOUT: ++num_timeout; break;
+  case Result::ERROR:   ++num_errors; break;
   default:
     UNREACHABLE();
   }
+  return r;
+}
+
+Result Solver::checkCore(const vector<expr> &assumptions,
+                         vector<expr> &core) const {
+  core.clear();
+  if (config::skip_smt)
+    return Result::SKIP;
+
+  if (!valid)
+    return Result::INVALID;
+
+  vector<Z3_ast> lits;
+  for (auto &a : assumptions) {
+    lits.emplace_back(a());
+  }
+
+  auto r = Z3Backend::toResult(s,
+             Z3_solver_check_assumptions(ctx(), s, lits.size(), lits.data()));
+  if (r.isUnsat()) {
+    auto vect = Z3_solver_get_unsat_core(ctx(), s);
+    Z3_ast_vector_inc_ref(ctx(), vect);
+    for (unsigned i = 0, e = Z3_ast_vector_size(ctx(), vect); i != e; ++i) {
+      core.emplace_back(Z3_ast_vector_get(ctx(), vect, i));
+    }
+    Z3_ast_vector_dec_ref(ctx(), vect);
+  }
+  return r;
 }
 
 void Solver::check(initializer_list<E> queries) {
-  for (auto &[q, error] : queries) {
+  for (auto &[mk_query, error] : queries) {
+    auto q = mk_query();
     if (!q.isValid()) {
       ++num_invalid;
       error(Result::INVALID);
@@ -344,8 +1085,10 @@ void Solver::check(initializer_list<E> queries) {
   }
 }
 
-Result check_expr(const expr &e) {
+Result check_expr(const expr &e, unsigned timeout_ms) {
   Solver s;
+  if (timeout_ms)
+    s.setTimeout(timeout_ms);
   s.add(e);
   return s.check();
 }
@@ -369,6 +1112,9 @@ void solver_print_stats(ostream &os) {
         "Num errors:  " << num_errors << " (" << error_pc << "%)\n"
         "Num SAT:     " << num_sats << " (" << sat_pc << "%)\n"
         "Num UNSAT:   " << num_unsats << " (" << unsat_pc << "%)\n";
+  if (num_external)
+    os << "Num external solver queries: " << num_external << '\n';
+  aig_print_stats(os);
 }
 
 
@@ -381,6 +1127,23 @@ EnableSMTQueriesTMP::~EnableSMTQueriesTMP() {
 }
 
 
+void solver_set_external(QueryClass qc, string cmd) {
+  auto &backend = external_backends[(unsigned)qc];
+  if (cmd.empty())
+    backend.reset();
+  else
+    backend = make_unique<ExternalBackend>(move(cmd),
+                                           qc == QueryClass::QF_BV ? "QF_BV"
+                                                                   : nullptr);
+}
+
+void solver_set_aig(bool enable, bool sweep) {
+  if (enable)
+    aig_backend = make_unique<AIGBackend>(sweep);
+  else
+    aig_backend.reset();
+}
+
 void solver_init() {
   tactic.emplace({
     "simplify",
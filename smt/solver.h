@@ -7,9 +7,12 @@
 #include <cassert>
 #include <cstdint>
 #include <functional>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 typedef struct _Z3_model* Z3_model;
 typedef struct _Z3_solver* Z3_solver;
@@ -19,6 +22,16 @@ namespace smt {
 class Model {
   Z3_model m;
 
+  // Bool and bit-vector terms of up to 64 bits are evaluated natively,
+  // with the values of the model's constants and of the shared subterms
+  // cached. Other terms are given to Z3, and their values are cached if
+  // they fit.
+  // ast id -> (ast, value or nullopt if unknown)
+  mutable std::unordered_map<unsigned, std::pair<expr, std::optional<uint64_t>>>
+    eval_cache;
+  std::optional<uint64_t> evalNative(Z3_ast a) const;
+  std::optional<uint64_t> evalZ3(Z3_ast a) const;
+
   Model() : m(0) {}
   Model(Z3_model m);
   ~Model();
@@ -28,6 +41,7 @@ class Model {
 public:
   Model(Model &&other) : m(0) {
     std::swap(other.m, m);
+    std::swap(other.eval_cache, eval_cache);
   }
 
   void operator=(Model &&other);
@@ -86,8 +100,43 @@ private:
   Result(Z3_model m) : m(m), a(SAT) {}
 
   friend class Solver;
+  friend class SolverBackend;
+};
+
+
+// A procedure that decides the assertions of a Z3 solver object.
+// The default backend is Z3 itself; others may translate the assertions and
+// hand them over to a different solver.
+class SolverBackend {
+public:
+  // timeout_ms is the query's time budget; the Z3 solver object s has it set
+  // already, but other solvers must enforce it themselves
+  virtual Result check(Z3_solver s, unsigned timeout_ms) = 0;
+  virtual ~SolverBackend() {}
+
+protected:
+  static Result mkResult(Result::answer a, std::string &&reason = {}) {
+    return { a, std::move(reason) };
+  }
+  static Result mkSat(Z3_model m) { return m; }
+  static void add(Z3_solver s, const expr &e);
+  // complete a partial model (given as equalities) of the assertions of s
+  static Result completeModel(Z3_solver s, const std::vector<expr> &model);
 };
 
+// Queries are dispatched to a backend based on their class
+enum class QueryClass { QF_BV, Other };
+
+// Use an external SMT-LIB2 solver for the given class of queries. The command
+// is run through the shell, reads the query from stdin, and must print the
+// answer and the model (if sat) to stdout. The model is completed by Z3; if
+// it can't be used, Z3 solves the query again. An empty command selects Z3.
+void solver_set_external(QueryClass qc, std::string cmd);
+
+// Decide QF_BV queries through an in-tree AIG bit-blaster, optionally with
+// SAT sweeping. Ignored for queries sent to an external solver.
+void solver_set_aig(bool enable, bool sweep = false);
+
 
 class Solver;
 
@@ -101,8 +150,10 @@ public:
 
 class Solver {
   Z3_solver s;
+  unsigned timeout_ms = 0; // 0: use the global query timeout
   bool valid = true;
-  using E = std::pair<expr, std::function<void(const Result &r)>>;
+  using E = std::pair<std::function<expr()>,
+                      std::function<void(const Result &r)>>;
 public:
   Solver(bool simple = false);
   ~Solver();
@@ -111,16 +162,26 @@ public:
   // use a negated solver for minimization
   void block(const Model &m, Solver *sneg = nullptr);
   void reset();
+  // Overrides the global query timeout for this solver
+  void setTimeout(unsigned ms);
 
   expr assertions() const;
 
   Result check() const;
+  // Checks the queries in order until one isn't unsat. Each query's function
+  // is only called once the previous queries have been checked.
   static void check(std::initializer_list<E> queries);
 
+  // Checks the assertions assuming the given boolean literals hold. If unsat,
+  // core is set to a subset of the literals that is enough for unsat.
+  // Not accounted in the statistics.
+  Result checkCore(const std::vector<expr> &assumptions,
+                   std::vector<expr> &core) const;
+
   friend class SolverPush;
 };
 
-Result check_expr(const expr &e);
+Result check_expr(const expr &e, unsigned timeout_ms = 0);
 
 
 void solver_print_queries(bool yes);
@@ -0,0 +1,19 @@
+; TEST-ARGS: -disable-undef-input -disable-poison-input
+; CHECK: define i8 @src() {
+; CHECK-NOT: %junk
+
+define i8 @src(i8 %x, i8 %y, i8* %p) {
+  %junk1 = mul i8 %y, %y
+  %junk2 = udiv i8 %junk1, 3
+  store i8 %junk2, i8* %p
+  %r = add i8 %x, 1
+  ret i8 %r
+}
+
+define i8 @tgt(i8 %x, i8 %y, i8* %p) {
+  %junk1 = mul i8 %y, %y
+  %junk2 = udiv i8 %junk1, 3
+  store i8 %junk2, i8* %p
+  %r = add i8 %x, 2
+  ret i8 %r
+}
@@ -0,0 +1,17 @@
+; TEST-ARGS: -axiom-stats
+; %p is never used, so its dereferenceability axiom isn't added.
+; CHECK: global-block: used in 1 of 1 proofs
+; CHECK-NOT: input-deref
+
+@g = global i32 0, align 4
+
+define i1 @src(i8* dereferenceable(4) %p) {
+  %i = ptrtoint i32* @g to i64
+  %a = and i64 %i, 3
+  %z = icmp eq i64 %a, 0
+  ret i1 %z
+}
+
+define i1 @tgt(i8* dereferenceable(4) %p) {
+  ret i1 true
+}
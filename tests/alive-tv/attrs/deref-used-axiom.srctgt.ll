@@ -0,0 +1,12 @@
+; TEST-ARGS: -axiom-stats
+; %p is compared, so its dereferenceability axiom is added.
+; CHECK: input-deref: used in 1 of 1 proofs
+
+define i1 @src(i8* dereferenceable(4) %p) {
+  %z = icmp eq i8* %p, null
+  ret i1 %z
+}
+
+define i1 @tgt(i8* dereferenceable(4) %p) {
+  ret i1 false
+}
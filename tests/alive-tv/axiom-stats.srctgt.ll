@@ -0,0 +1,15 @@
+; TEST-ARGS: -axiom-stats
+; CHECK: global-block: used in 1 of 1 proofs
+
+@g = global i32 0, align 4
+
+define i1 @src() {
+  %i = ptrtoint i32* @g to i64
+  %a = and i64 %i, 3
+  %z = icmp eq i64 %a, 0
+  ret i1 %z
+}
+
+define i1 @tgt() {
+  ret i1 true
+}
@@ -0,0 +1,21 @@
+@g = global i8 0
+@h = global i8 0
+
+declare void @f(i8* readonly, i8*) argmemonly
+
+define i8 @src() {
+  store i8 1, i8* @g
+  store i8 2, i8* @h
+  call void @f(i8* @g, i8* @h)
+  %v = load i8, i8* @h
+  ret i8 %v
+}
+
+define i8 @tgt() {
+  store i8 1, i8* @g
+  store i8 2, i8* @h
+  call void @f(i8* @g, i8* @h)
+  ret i8 2
+}
+
+; ERROR: Value mismatch
@@ -0,0 +1,26 @@
+; TEST-ARGS: -axiom-stats
+; The pointer loaded after the call is non-local by construction of the
+; call-result memory, so the proof doesn't need the non-local value axioms.
+; CHECK: nonlocal-val: used in 0 of 1 proofs
+
+@g = global i8* null
+declare void @f()
+
+define i8 @src() {
+  %a = alloca i8
+  call void @f()
+  store i8 1, i8* %a
+  %p = load i8*, i8** @g
+  store i8 2, i8* %p
+  %v = load i8, i8* %a
+  ret i8 %v
+}
+
+define i8 @tgt() {
+  %a = alloca i8
+  call void @f()
+  store i8 1, i8* %a
+  %p = load i8*, i8** @g
+  store i8 2, i8* %p
+  ret i8 1
+}
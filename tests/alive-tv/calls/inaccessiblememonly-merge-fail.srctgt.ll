@@ -0,0 +1,16 @@
+declare i32 @rand() inaccessiblememonly
+
+define i32 @src() {
+  %a = call i32 @rand()
+  %b = call i32 @rand()
+  %c = sub i32 %a, %b
+  ret i32 %c
+}
+
+define i32 @tgt() {
+  %a = call i32 @rand()
+  %c = sub i32 %a, %a
+  ret i32 %c
+}
+
+; ERROR: Value mismatch
@@ -0,0 +1,16 @@
+@g = global i8 0
+
+declare void @f(i8*) inaccessiblememonly
+
+define i8 @src(i8* %p) {
+  store i8 1, i8* @g
+  call void @f(i8* %p)
+  %v = load i8, i8* @g
+  ret i8 %v
+}
+
+define i8 @tgt(i8* %p) {
+  store i8 1, i8* @g
+  call void @f(i8* %p)
+  ret i8 1
+}
@@ -0,0 +1,19 @@
+; TEST-ARGS: -smt-stats -disable-undef-input -disable-poison-input
+; All the values in the counterexample are invertible functions of an input,
+; so printing them as arbitrary doesn't need any SMT query.
+; CHECK: Num queries: 7
+; ERROR: Value mismatch
+
+define i8 @src(i8 %x, i8 %y) {
+  %a = add i8 %x, 1
+  %b = mul i8 %y, 3
+  %c = add i8 %a, %b
+  ret i8 %c
+}
+
+define i8 @tgt(i8 %x, i8 %y) {
+  %a = add i8 %x, 2
+  %b = mul i8 %y, 3
+  %c = add i8 %a, %b
+  ret i8 %c
+}
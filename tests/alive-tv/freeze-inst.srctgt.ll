@@ -0,0 +1,19 @@
+; TEST-ARGS: -disable-undef-input
+
+define i32 @src(i32 %x, i32 %y) {
+  %a = add nsw i32 %x, %y
+  %f = freeze i32 %a
+  %m = mul i32 %f, %f
+  %n = mul i32 %m, %f
+  %r = urem i32 %n, 7
+  ret i32 %r
+}
+
+define i32 @tgt(i32 %x, i32 %y) {
+  %a = add nsw i32 %x, %y
+  %f = freeze i32 %a
+  %m = mul i32 %f, %f
+  %n = mul i32 %f, %m
+  %r = urem i32 %n, 7
+  ret i32 %r
+}
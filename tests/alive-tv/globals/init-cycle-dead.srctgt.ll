@@ -0,0 +1,16 @@
+; The function only returns the address of @a, so the initializers of the
+; cycle @a <-> @b aren't needed.
+%node = type { %node*, i32 }
+
+@a = constant %node { %node* @b, i32 1 }
+@b = constant %node { %node* @a, i32 2 }
+
+define %node* @src() {
+  ret %node* @a
+}
+
+define %node* @tgt() {
+  ret %node* @a
+}
+
+; CHECK-NOT: store
@@ -0,0 +1,18 @@
+%node = type { %node*, i32 }
+
+@a = constant %node { %node* @b, i32 1 }
+@b = constant %node { %node* @a, i32 2 }
+
+define i32 @src() {
+  %p = getelementptr %node, %node* @a, i32 0, i32 0
+  %b = load %node*, %node** %p
+  %r = getelementptr %node, %node* %b, i32 0, i32 1
+  %v = load i32, i32* %r
+  ret i32 %v
+}
+
+define i32 @tgt() {
+  ret i32 1
+}
+
+; ERROR: Value mismatch
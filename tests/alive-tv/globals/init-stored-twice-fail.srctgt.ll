@@ -0,0 +1,16 @@
+@x = constant i32 42
+@y = constant i32 43
+@p = constant i32* @x
+@q = constant i32* @y
+
+define i32 @src() {
+  %x = load i32*, i32** @q
+  %v = load i32, i32* %x
+  ret i32 %v
+}
+
+define i32 @tgt() {
+  ret i32 42
+}
+
+; ERROR: Value mismatch
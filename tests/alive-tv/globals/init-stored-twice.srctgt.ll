@@ -0,0 +1,14 @@
+; @x is stored in the initializers of both @p and @q, but only @q is read.
+@x = constant i32 42
+@p = constant i32* @x
+@q = constant i32* @x
+
+define i32 @src() {
+  %x = load i32*, i32** @q
+  %v = load i32, i32* %x
+  ret i32 %v
+}
+
+define i32 @tgt() {
+  ret i32 42
+}
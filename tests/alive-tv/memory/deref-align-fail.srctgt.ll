@@ -0,0 +1,13 @@
+; A check with a smaller alignment doesn't cover one with a larger alignment.
+define i32 @src(i32* noundef %p) {
+  %v = load i32, i32* %p, align 1
+  ret i32 %v
+}
+
+define i32 @tgt(i32* noundef %p) {
+  %v = load i32, i32* %p, align 1
+  %w = load i32, i32* %p, align 4
+  ret i32 %v
+}
+
+; ERROR: Source is more defined than target
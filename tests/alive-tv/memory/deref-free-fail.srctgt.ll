@@ -0,0 +1,17 @@
+; Freeing the block invalidates the earlier check.
+declare void @free(i8*)
+
+define void @src(i8* noundef %p) {
+  %v = load i8, i8* %p
+  call void @free(i8* noundef %p)
+  ret void
+}
+
+define void @tgt(i8* noundef %p) {
+  %v = load i8, i8* %p
+  call void @free(i8* noundef %p)
+  %w = load i8, i8* %p
+  ret void
+}
+
+; ERROR: Source is more defined than target
@@ -0,0 +1,32 @@
+; The check done in only one of the predecessors doesn't cover the load after
+; the join.
+define i32 @src(i32* noundef %p, i1 %c) {
+  br i1 %c, label %then, label %else
+
+then:
+  %v = load i32, i32* %p, align 4
+  br label %join
+
+else:
+  br label %join
+
+join:
+  ret i32 0
+}
+
+define i32 @tgt(i32* noundef %p, i1 %c) {
+  br i1 %c, label %then, label %else
+
+then:
+  %v = load i32, i32* %p, align 4
+  br label %join
+
+else:
+  br label %join
+
+join:
+  %w = load i32, i32* %p, align 4
+  ret i32 0
+}
+
+; ERROR: Source is more defined than target
@@ -0,0 +1,33 @@
+; The load after the join is covered by the checks in both predecessors.
+define i32 @src(i32* noundef %p, i1 %c) {
+  br i1 %c, label %then, label %else
+
+then:
+  %a = load i32, i32* %p, align 4
+  br label %join
+
+else:
+  store i32 0, i32* %p, align 4
+  br label %join
+
+join:
+  %r = phi i32 [ %a, %then ], [ 0, %else ]
+  %w = load i32, i32* %p, align 4
+  ret i32 %r
+}
+
+define i32 @tgt(i32* noundef %p, i1 %c) {
+  br i1 %c, label %then, label %else
+
+then:
+  %a = load i32, i32* %p, align 4
+  br label %join
+
+else:
+  store i32 0, i32* %p, align 4
+  br label %join
+
+join:
+  %r = phi i32 [ %a, %then ], [ 0, %else ]
+  ret i32 %r
+}
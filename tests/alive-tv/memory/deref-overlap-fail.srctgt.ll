@@ -0,0 +1,15 @@
+; A 1 byte load doesn't cover a 4 byte one.
+define i8 @src(i32* noundef %p) {
+  %q = bitcast i32* %p to i8*
+  %v = load i8, i8* %q, align 1
+  ret i8 %v
+}
+
+define i8 @tgt(i32* noundef %p) {
+  %q = bitcast i32* %p to i8*
+  %v = load i8, i8* %q, align 1
+  %w = load i32, i32* %p, align 1
+  ret i8 %v
+}
+
+; ERROR: Source is more defined than target
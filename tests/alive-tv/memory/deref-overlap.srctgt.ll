@@ -0,0 +1,12 @@
+; The 2 byte load is covered by the check of the 4 byte store.
+define void @src(i32* noundef %p, i32 %x) {
+  store i32 %x, i32* %p, align 4
+  ret void
+}
+
+define void @tgt(i32* noundef %p, i32 %x) {
+  store i32 %x, i32* %p, align 4
+  %q = bitcast i32* %p to i16*
+  %v = load i16, i16* %q, align 2
+  ret void
+}
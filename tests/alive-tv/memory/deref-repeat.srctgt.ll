@@ -0,0 +1,13 @@
+; The second load is covered by the dereferenceability check of the first.
+define i32 @src(i32* noundef %p) {
+  %a = load i32, i32* %p, align 4
+  %b = load i32, i32* %p, align 4
+  %c = add i32 %a, %b
+  ret i32 %c
+}
+
+define i32 @tgt(i32* noundef %p) {
+  %a = load i32, i32* %p, align 4
+  %c = shl i32 %a, 1
+  ret i32 %c
+}
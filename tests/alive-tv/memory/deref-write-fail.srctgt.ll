@@ -0,0 +1,15 @@
+; A read check doesn't cover a write to a constant global.
+@g = constant i32 1
+
+define i32 @src() {
+  %v = load i32, i32* @g, align 4
+  ret i32 %v
+}
+
+define i32 @tgt() {
+  %v = load i32, i32* @g, align 4
+  store i32 %v, i32* @g, align 4
+  ret i32 %v
+}
+
+; ERROR: Source is more defined than target
@@ -0,0 +1,13 @@
+define i32 @src(float %x, float* %p) {
+  store float %x, float* %p
+  %q = bitcast float* %p to i32*
+  %v = load i32, i32* %q
+  ret i32 %v
+}
+
+define i32 @tgt(float %x, float* %p) {
+  %v = bitcast float %x to i32
+  %q = bitcast float* %p to i32*
+  store i32 %v, i32* %q
+  ret i32 %v
+}
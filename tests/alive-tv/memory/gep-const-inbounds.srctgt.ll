@@ -0,0 +1,14 @@
+; The intermediate pointer of the GEP in @tgt is out of bounds, so the
+; constant indices cannot be folded into a zero offset.
+
+define i8* @src([4 x i8]* %p) {
+  %q = bitcast [4 x i8]* %p to i8*
+  ret i8* %q
+}
+
+define i8* @tgt([4 x i8]* %p) {
+  %q = getelementptr inbounds [4 x i8], [4 x i8]* %p, i64 -1, i64 4
+  ret i8* %q
+}
+
+; ERROR: Target is more poisonous than source
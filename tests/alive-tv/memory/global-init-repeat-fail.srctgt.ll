@@ -0,0 +1,13 @@
+@t = constant [16 x i32] [i32 7, i32 7, i32 7, i32 7, i32 7, i32 7, i32 7, i32 7, i32 7, i32 7, i32 7, i32 7, i32 7, i32 8, i32 7, i32 7]
+
+define i32 @src(i64 %i) {
+  %p = getelementptr inbounds [16 x i32], [16 x i32]* @t, i64 0, i64 %i
+  %v = load i32, i32* %p, align 4
+  ret i32 %v
+}
+
+define i32 @tgt(i64 %i) {
+  ret i32 7
+}
+
+; ERROR: Value mismatch
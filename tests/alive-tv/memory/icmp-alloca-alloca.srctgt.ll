@@ -0,0 +1,10 @@
+define i1 @src() {
+  %p = alloca i8
+  %q = alloca i8
+  %c = icmp eq i8* %p, %q
+  ret i1 %c
+}
+
+define i1 @tgt() {
+  ret i1 false
+}
@@ -0,0 +1,11 @@
+@g = global i8 0
+
+define i1 @src() {
+  %p = alloca i8
+  %c = icmp eq i8* %p, @g
+  ret i1 %c
+}
+
+define i1 @tgt() {
+  ret i1 false
+}
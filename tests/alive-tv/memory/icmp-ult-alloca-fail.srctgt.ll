@@ -0,0 +1,12 @@
+define i1 @src() {
+  ret i1 false
+}
+
+define i1 @tgt() {
+  %p = alloca i8
+  %q = alloca i8
+  %c = icmp ult i8* %p, %q
+  ret i1 %c
+}
+
+; ERROR: Value mismatch
@@ -0,0 +1,12 @@
+declare i8* @memchr(i8*, i32, i64)
+@s = constant [4 x i8] c"abcd"
+
+define i8* @src() {
+  %g = getelementptr [4 x i8], [4 x i8]* @s, i64 0, i64 0
+  %r = call i8* @memchr(i8* %g, i32 100, i64 3)
+  ret i8* %r
+}
+
+define i8* @tgt() {
+  ret i8* null
+}
@@ -0,0 +1,12 @@
+declare i8* @memmove(i8*, i8*, i64)
+declare void @llvm.memmove.p0i8.p0i8.i64(i8*, i8*, i64, i1)
+
+define i8* @src(i8* %p, i8* %q, i64 %n) {
+  %r = call i8* @memmove(i8* %p, i8* %q, i64 %n)
+  ret i8* %r
+}
+
+define i8* @tgt(i8* %p, i8* %q, i64 %n) {
+  call void @llvm.memmove.p0i8.p0i8.i64(i8* %p, i8* %q, i64 %n, i1 false)
+  ret i8* %p
+}
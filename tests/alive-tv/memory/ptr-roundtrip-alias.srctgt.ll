@@ -0,0 +1,23 @@
+; TEST-ARGS: -alias-stats -disable-undef-input
+; The block id of a pointer loaded back from memory must be the same term as
+; that of the stored pointer, or the alias sets grow.
+; CHECK: 2: 44.4%
+
+define i8 @src(i8** %pp, i8* %p, i8* %r) {
+  store i8* %p, i8** %pp
+  %q = load i8*, i8** %pp
+  %g = getelementptr i8, i8* %q, i64 4
+  store i8 1, i8* %g
+  store i8 2, i8* %r
+  %v = load i8, i8* %g
+  ret i8 %v
+}
+
+define i8 @tgt(i8** %pp, i8* %p, i8* %r) {
+  store i8* %p, i8** %pp
+  %g = getelementptr i8, i8* %p, i64 4
+  store i8 1, i8* %g
+  store i8 2, i8* %r
+  %v = load i8, i8* %g
+  ret i8 %v
+}
@@ -0,0 +1,46 @@
+; The memory of a single return differs.
+define <2 x i8*> @src(i8* %p, i8* %q, i8 %c) {
+  switch i8 %c, label %d [
+    i8 0, label %a
+    i8 1, label %b
+  ]
+
+a:
+  store i8 0, i8* %p
+  %va = insertelement <2 x i8*> undef, i8* %p, i32 0
+  %wa = insertelement <2 x i8*> %va, i8* %q, i32 1
+  ret <2 x i8*> %wa
+
+b:
+  store i8 1, i8* %q
+  %vb = insertelement <2 x i8*> undef, i8* %q, i32 0
+  %wb = insertelement <2 x i8*> %vb, i8* %p, i32 1
+  ret <2 x i8*> %wb
+
+d:
+  ret <2 x i8*> zeroinitializer
+}
+
+define <2 x i8*> @tgt(i8* %p, i8* %q, i8 %c) {
+  switch i8 %c, label %d [
+    i8 0, label %a
+    i8 1, label %b
+  ]
+
+a:
+  store i8 0, i8* %p
+  %va = insertelement <2 x i8*> undef, i8* %p, i32 0
+  %wa = insertelement <2 x i8*> %va, i8* %q, i32 1
+  ret <2 x i8*> %wa
+
+b:
+  store i8 2, i8* %q
+  %vb = insertelement <2 x i8*> undef, i8* %q, i32 0
+  %wb = insertelement <2 x i8*> %vb, i8* %p, i32 1
+  ret <2 x i8*> %wb
+
+d:
+  ret <2 x i8*> zeroinitializer
+}
+
+; ERROR: Mismatch in memory
\ No newline at end of file
@@ -0,0 +1,14 @@
+; TEST-ARGS: -memory-soa -disable-undef-input
+
+define void @src(i8** %p, i8* %q) {
+  store i8* %q, i8** %p
+  ret void
+}
+
+define void @tgt(i8** %p, i8* %q) {
+  %r = getelementptr inbounds i8, i8* %q, i64 0
+  store i8* %r, i8** %p
+  ret void
+}
+
+; ERROR: Mismatch in memory
@@ -0,0 +1,15 @@
+declare i8* @stpcpy(i8*, i8*)
+declare i8* @strcpy(i8*, i8*)
+declare i64 @strlen(i8*)
+
+define i8* @src(i8* %d, i8* %s) {
+  %r = call i8* @stpcpy(i8* %d, i8* %s)
+  ret i8* %r
+}
+
+define i8* @tgt(i8* %d, i8* %s) {
+  %n = call i64 @strlen(i8* %s)
+  %c = call i8* @strcpy(i8* %d, i8* %s)
+  %r = getelementptr inbounds i8, i8* %d, i64 %n
+  ret i8* %r
+}
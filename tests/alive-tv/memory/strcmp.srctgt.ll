@@ -0,0 +1,15 @@
+declare i32 @strcmp(i8*, i8*)
+@s = constant [4 x i8] c"abc\00"
+@t = constant [4 x i8] c"abd\00"
+
+define i1 @src() {
+  %g = getelementptr [4 x i8], [4 x i8]* @s, i64 0, i64 0
+  %h = getelementptr [4 x i8], [4 x i8]* @t, i64 0, i64 0
+  %r = call i32 @strcmp(i8* %g, i8* %h)
+  %c = icmp slt i32 %r, 0
+  ret i1 %c
+}
+
+define i1 @tgt() {
+  ret i1 true
+}
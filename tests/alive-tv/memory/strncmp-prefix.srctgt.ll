@@ -0,0 +1,14 @@
+declare i32 @strncmp(i8*, i8*, i64)
+@s = constant [4 x i8] c"abc\00"
+@t = constant [4 x i8] c"abd\00"
+
+define i32 @src() {
+  %g = getelementptr [4 x i8], [4 x i8]* @s, i64 0, i64 0
+  %h = getelementptr [4 x i8], [4 x i8]* @t, i64 0, i64 0
+  %r = call i32 @strncmp(i8* %g, i8* %h, i64 2)
+  ret i32 %r
+}
+
+define i32 @tgt() {
+  ret i32 0
+}
@@ -0,0 +1,10 @@
+declare i32 @strncmp(i8*, i8*, i64)
+
+define i32 @src(i8* %p, i8* %q) {
+  %r = call i32 @strncmp(i8* %p, i8* %q, i64 0)
+  ret i32 %r
+}
+
+define i32 @tgt(i8* %p, i8* %q) {
+  ret i32 0
+}
@@ -0,0 +1,21 @@
+define i64 @src(i64* %p, i64* %q, i64 %x) {
+  %v = load i64, i64* %p
+  %w = load i64, i64* %q
+  %a = add i64 %v, %w
+  %b = sub i64 %a, 3
+  %c = mul i64 %b, %w
+  %d = udiv i64 %c, 7
+  %r = xor i64 %d, %x
+  ret i64 %r
+}
+
+define i64 @tgt(i64* %p, i64* %q, i64 %x) {
+  %v = load i64, i64* %p
+  %w = load i64, i64* %q
+  %a = sub i64 %w, 3
+  %b = add i64 %a, %v
+  %c = mul i64 %w, %b
+  %d = udiv i64 %c, 7
+  %r = xor i64 %x, %d
+  ret i64 %r
+}
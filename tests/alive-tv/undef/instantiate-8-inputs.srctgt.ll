@@ -0,0 +1,20 @@
+; TEST-ARGS: -smt-verbose
+; The formula is small, so all the 8 undef masks are instantiated rather than
+; stopping at 128 instances.
+; CHECK: (= isundef_%x7 #b1)
+; ERROR: Value mismatch
+
+define i1 @src(i1 %x0, i1 %x1, i1 %x2, i1 %x3, i1 %x4, i1 %x5, i1 %x6, i1 %x7) {
+  %a0 = or i1 %x0, %x1
+  %a1 = or i1 %a0, %x2
+  %a2 = or i1 %a1, %x3
+  %a3 = or i1 %a2, %x4
+  %a4 = or i1 %a3, %x5
+  %a5 = or i1 %a4, %x6
+  %a6 = or i1 %a5, %x7
+  ret i1 %a6
+}
+
+define i1 @tgt(i1 %x0, i1 %x1, i1 %x2, i1 %x3, i1 %x4, i1 %x5, i1 %x6, i1 %x7) {
+  ret i1 true
+}
@@ -4,7 +4,7 @@
 import lit.TestRunner
 import lit.util
 from .base import TestFormat
-import os, re, signal, string, subprocess
+import os, re, shutil, signal, string, subprocess
 
 ok_string = 'Transformation seems to be correct!'
 
@@ -60,7 +60,8 @@ class Alive2Test(TestFormat):
       if not filename.startswith('.') and \
           not os.path.isdir(filepath) and \
           (filename.endswith('.opt') or filename.endswith('.src.ll') or
-           filename.endswith('.srctgt.ll')):
+           filename.endswith('.srctgt.ll') or filename.endswith('.tv.ll') or
+           filename.endswith('.reduce.ll')):
         yield lit.Test.Test(testSuite, path_in_suite + (filename,), localConfig)
 
 
@@ -79,7 +80,21 @@ class Alive2Test(TestFormat):
       if not os.path.isfile('alive-tv'):
         return lit.Test.UNSUPPORTED, ''
 
-    if not alive_tv_1 and not alive_tv_2:
+    tv_plugin = test.endswith('.tv.ll')
+    if tv_plugin:
+      opt = shutil.which(os.environ.get('OPT', 'opt'))
+      if opt is None or not os.path.isfile('tv/tv.so'):
+        return lit.Test.UNSUPPORTED, ''
+      cmd = [opt, '-enable-new-pm=0', '-load=tv/tv.so', '-tv-smt-to=20000',
+             '-tv']
+
+    reduce = test.endswith('.reduce.ll')
+    if reduce:
+      if not os.path.isfile('alive-reduce'):
+        return lit.Test.UNSUPPORTED, ''
+      cmd = ['./alive-reduce']
+
+    if not alive_tv_1 and not alive_tv_2 and not tv_plugin and not reduce:
       cmd = ['./alive', '-smt-to:20000']
 
     input = readFile(test)
@@ -87,7 +102,8 @@ class Alive2Test(TestFormat):
     # add test-specific args
     m = self.regex_args.search(input)
     if m != None:
-      cmd += m.group(1).split()
+      # %S expands to the directory of the test, e.g., for helper scripts
+      cmd += m.group(1).replace('%S', os.path.dirname(test)).split()
 
     do_identity = self.regex_skip_identity.search(input) is None
 
@@ -107,6 +123,10 @@ class Alive2Test(TestFormat):
       except Exception as e:
         return lit.Test.FAIL, e
 
+    # the test args of tv tests are the passes to validate
+    if tv_plugin:
+      cmd += ['-tv', '-disable-output']
+
     cmd.append(test)
     if alive_tv_2:
       cmd.append(test.replace('.src.ll', '.tgt.ll'))
@@ -0,0 +1,5 @@
+#!/bin/sh
+# Answers sat with a model that doesn't fit the query
+cat > /dev/null
+echo sat
+echo "((define-fun bogus () (_ BitVec 8) #x00))"
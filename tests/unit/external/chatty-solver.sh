@@ -0,0 +1,7 @@
+#!/bin/sh
+# Prints more than fits in a pipe before reading the query, and then agrees
+# with anything; the model is left for Z3 to fill in.
+head -c 100000 /dev/zero | tr '\0' ' '
+cat > /dev/null
+echo sat
+echo "()"
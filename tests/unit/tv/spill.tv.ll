@@ -0,0 +1,22 @@
+; TEST-ARGS: -tv-saved-fns-mem=1 -tv-smt-stats -globaldce -instcombine
+; CHECK: Saved functions: 5 spilled to disk, 3 reloaded, 0 failed to reload
+; CHECK-NOT: Skipping
+
+define i8 @f(i8 %x) {
+  %a = add i8 %x, 0
+  %b = mul i8 %a, 2
+  ret i8 %b
+}
+
+define i8 @g(i8 %x, i8 %y) {
+  %a = xor i8 %x, -1
+  %b = xor i8 %a, -1
+  %c = sub i8 %b, %y
+  ret i8 %c
+}
+
+define i1 @h(i8 %x) {
+  %a = shl i8 %x, 1
+  %b = icmp eq i8 %a, 0
+  ret i1 %b
+}
@@ -0,0 +1,451 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "llvm_util/llvm2alive.h"
+#include "smt/smt.h"
+#include "tools/transform.h"
+#include "util/compiler.h"
+#include "util/config.h"
+#include "util/version.h"
+
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+using namespace tools;
+using namespace util;
+using namespace std;
+using namespace llvm_util;
+
+namespace {
+
+enum class Interesting { Same, Timeout, Slow };
+
+llvm::cl::OptionCategory opt_alive("Alive options");
+
+llvm::cl::opt<string>
+opt_file(llvm::cl::Positional, llvm::cl::desc("bitcode_file"),
+    llvm::cl::Required, llvm::cl::value_desc("filename"),
+    llvm::cl::cat(opt_alive));
+
+llvm::cl::opt<Interesting> opt_interesting(
+    "interesting",
+    llvm::cl::desc("What a reduced candidate must preserve (default=same)"),
+    llvm::cl::values(
+      clEnumValN(Interesting::Same, "same",
+                 "Fails with the same error as the input"),
+      clEnumValN(Interesting::Timeout, "timeout", "An SMT query times out"),
+      clEnumValN(Interesting::Slow, "slow",
+                 "Verification takes at least -min-time")),
+    llvm::cl::init(Interesting::Same), llvm::cl::cat(opt_alive));
+
+llvm::cl::opt<unsigned> opt_min_time(
+    "min-time",
+    llvm::cl::desc("Min verification time for -interesting=slow "
+                   "(default=1000)"),
+    llvm::cl::init(1000), llvm::cl::value_desc("ms"),
+    llvm::cl::cat(opt_alive));
+
+llvm::cl::opt<bool> opt_disable_undef("disable-undef-input",
+    llvm::cl::init(false), llvm::cl::cat(opt_alive),
+    llvm::cl::desc("Assume inputs are not undef (default=false)"));
+
+llvm::cl::opt<bool> opt_disable_poison("disable-poison-input",
+    llvm::cl::init(false), llvm::cl::cat(opt_alive),
+    llvm::cl::desc("Assume inputs are not poison (default=false)"));
+
+llvm::cl::opt<unsigned> opt_smt_to(
+    "smt-to", llvm::cl::desc("Timeout for SMT queries (default=10000)"),
+    llvm::cl::init(10000), llvm::cl::value_desc("ms"),
+    llvm::cl::cat(opt_alive));
+
+llvm::cl::opt<unsigned> opt_max_mem(
+     "max-mem", llvm::cl::desc("Max memory (approx)"),
+     llvm::cl::cat(opt_alive), llvm::cl::init(1024), llvm::cl::value_desc("MB"));
+
+llvm::cl::opt<std::string> opt_src_fn(
+    "src-fn", llvm::cl::desc("Name of src function (without @)"),
+    llvm::cl::cat(opt_alive), llvm::cl::init("src"));
+
+llvm::cl::opt<std::string> opt_tgt_fn(
+    "tgt-fn", llvm::cl::desc("Name of tgt function (without @)"),
+    llvm::cl::cat(opt_alive), llvm::cl::init("tgt"));
+
+llvm::cl::opt<string> opt_outputfile("o",
+    llvm::cl::init("-"), llvm::cl::cat(opt_alive),
+    llvm::cl::desc("Specify output filename (default=stdout)"));
+
+
+optional<smt::smt_initializer> smt_init;
+llvm::Triple targetTriple;
+string input_error;
+unsigned num_tests = 0;
+
+struct Outcome {
+  string error; // first error reported; empty if correct
+  bool timeout = false;
+  chrono::milliseconds time;
+};
+
+// Returns nothing if src/tgt can't be verified at all
+optional<Outcome> verify(llvm::Module &M) {
+  auto *F1 = M.getFunction(opt_src_fn);
+  auto *F2 = M.getFunction(opt_tgt_fn);
+  if (!F1 || !F2 || F1->isDeclaration() || F2->isDeclaration() ||
+      F1->getFunctionType() != F2->getFunctionType())
+    return {};
+
+  auto Func1 = llvm2alive(*F1, llvm::TargetLibraryInfoWrapperPass(targetTriple)
+                                     .getTLI(*F1));
+  if (!Func1)
+    return {};
+
+  auto Func2 = llvm2alive(*F2, llvm::TargetLibraryInfoWrapperPass(targetTriple)
+                                     .getTLI(*F2), Func1->getGlobalVarNames());
+  if (!Func2)
+    return {};
+
+  auto start = chrono::steady_clock::now();
+  smt_init->reset();
+  Transform t;
+  t.src = move(*Func1);
+  t.tgt = move(*Func2);
+  t.preprocess();
+  TransformVerify verifier(t, false);
+  if (!verifier.getTypings())
+    return {};
+
+  Errors errs = verifier.verify();
+  Outcome r;
+  r.time = chrono::duration_cast<chrono::milliseconds>(
+             chrono::steady_clock::now() - start);
+
+  stringstream ss;
+  ss << errs;
+  for (string line; getline(ss, line); ) {
+    if (line.rfind("ERROR: ", 0) != 0)
+      continue;
+    if (r.error.empty())
+      r.error = line;
+    r.timeout |= line == "ERROR: Timeout";
+  }
+  return r;
+}
+
+bool is_interesting(llvm::Module &M) {
+  if (llvm::verifyModule(M))
+    return false;
+
+  ++num_tests;
+  auto r = verify(M);
+  if (!r)
+    return false;
+
+  switch (opt_interesting) {
+  case Interesting::Same:    return r->error == input_error;
+  case Interesting::Timeout: return r->timeout;
+  case Interesting::Slow:    return r->time.count() >= opt_min_time;
+  }
+  UNREACHABLE();
+}
+
+
+struct Reduction {
+  const char *name;
+  // The parts of the module this reduction can remove, in a stable order
+  function<vector<llvm::Value*>(llvm::Module&)> units;
+  // Removes the given units; they must not be returned by units() afterwards
+  function<void(llvm::Module&, vector<llvm::Value*>&&)> apply;
+};
+
+vector<llvm::Function*> src_tgt(llvm::Module &M) {
+  vector<llvm::Function*> fns;
+  for (auto &name : { opt_src_fn.getValue(), opt_tgt_fn.getValue() }) {
+    if (auto *F = M.getFunction(name); F && !F->isDeclaration())
+      fns.emplace_back(F);
+  }
+  return fns;
+}
+
+bool is_src_tgt(const llvm::Function &F) {
+  return F.getName() == opt_src_fn || F.getName() == opt_tgt_fn;
+}
+
+// Delta debugging: tries to remove chunks of units, halving the chunk size
+// down to single units, and keeps every candidate that is still interesting
+bool reduce(unique_ptr<llvm::Module> &M, const Reduction &R) {
+  bool changed = false;
+  size_t n = R.units(*M).size();
+
+  for (size_t chunk = max(n / 2, size_t(1)); n > 0; chunk /= 2) {
+    for (size_t i = 0; i < n; ) {
+      auto candidate = llvm::CloneModule(*M);
+      auto units = R.units(*candidate);
+      R.apply(*candidate,
+              { units.begin() + i, units.begin() + min(i + chunk, n) });
+
+      if (is_interesting(*candidate)) {
+        M = move(candidate);
+        changed = true;
+        size_t new_n = R.units(*M).size();
+        if (new_n >= n)
+          i += chunk;
+        n = new_n;
+        cerr << "[" << num_tests << " tests] " << R.name << ": " << n
+             << " left" << endl;
+      } else {
+        i += chunk;
+      }
+    }
+    if (chunk == 1)
+      break;
+  }
+  return changed;
+}
+
+// Instructions are replaced with one of their operands of the same type if
+// possible (those dominate all the uses), or with a null value otherwise.
+const Reduction instructions = {
+  "instructions",
+  [](llvm::Module &M) {
+    vector<llvm::Value*> units;
+    for (auto *F : src_tgt(M)) {
+      for (auto &BB : *F) {
+        for (auto &I : BB) {
+          if (!I.isTerminator())
+            units.emplace_back(&I);
+        }
+      }
+    }
+    return units;
+  },
+  [](llvm::Module &M, vector<llvm::Value*> &&units) {
+    for (auto *V : units) {
+      auto *I = llvm::cast<llvm::Instruction>(V);
+      if (I->getType()->isVoidTy())
+        continue;
+
+      llvm::Value *repl = nullptr;
+      if (!llvm::isa<llvm::PHINode>(I)) {
+        for (auto &op : I->operands()) {
+          if (op->getType() == I->getType()) {
+            repl = op;
+            break;
+          }
+        }
+      }
+      I->replaceAllUsesWith(repl ? repl
+                                 : llvm::Constant::getNullValue(I->getType()));
+    }
+    for (auto *V : units) {
+      llvm::cast<llvm::Instruction>(V)->eraseFromParent();
+    }
+  }
+};
+
+// Makes conditional branches and switches always go to their first or last
+// successor, and then removes the blocks that become unreachable
+Reduction branches(bool last) {
+  return {
+    last ? "branches (last successor)" : "branches (first successor)",
+    [](llvm::Module &M) {
+      vector<llvm::Value*> units;
+      for (auto *F : src_tgt(M)) {
+        for (auto &BB : *F) {
+          auto *T = BB.getTerminator();
+          if (T && T->getNumSuccessors() > 1 &&
+              (llvm::isa<llvm::BranchInst>(T) || llvm::isa<llvm::SwitchInst>(T)))
+            units.emplace_back(T);
+        }
+      }
+      return units;
+    },
+    [=](llvm::Module &M, vector<llvm::Value*> &&units) {
+      for (auto *V : units) {
+        auto *T = llvm::cast<llvm::Instruction>(V);
+        auto *BB = T->getParent();
+        unsigned n = T->getNumSuccessors();
+        unsigned keep = last ? n - 1 : 0;
+        for (unsigned i = 0; i != n; ++i) {
+          if (i != keep)
+            T->getSuccessor(i)->removePredecessor(BB, true);
+        }
+        llvm::BranchInst::Create(T->getSuccessor(keep), T);
+        T->eraseFromParent();
+      }
+      for (auto *F : src_tgt(M)) {
+        llvm::removeUnreachableBlocks(*F);
+      }
+    }
+  };
+}
+
+// Removes arguments of both src and tgt, replacing their uses with null
+const Reduction arguments = {
+  "arguments",
+  [](llvm::Module &M) {
+    vector<llvm::Value*> units;
+    auto fns = src_tgt(M);
+    if (fns.size() != 2 || !fns[0]->use_empty() || !fns[1]->use_empty() ||
+        fns[0]->arg_size() != fns[1]->arg_size())
+      return units;
+
+    for (auto &arg : fns[0]->args()) {
+      units.emplace_back(&arg);
+    }
+    return units;
+  },
+  [](llvm::Module &M, vector<llvm::Value*> &&units) {
+    vector<unsigned> idxs;
+    for (auto *V : units) {
+      idxs.emplace_back(llvm::cast<llvm::Argument>(V)->getArgNo());
+    }
+
+    for (auto *F : src_tgt(M)) {
+      llvm::ValueToValueMapTy vmap;
+      for (auto idx : idxs) {
+        auto *arg = F->getArg(idx);
+        vmap[arg] = llvm::Constant::getNullValue(arg->getType());
+      }
+      // cloning drops the arguments that are mapped to some value
+      auto *NF = llvm::CloneFunction(F, vmap);
+      NF->takeName(F);
+      F->eraseFromParent();
+    }
+  }
+};
+
+// Removes global variables and other functions, replacing their uses with
+// null. Unused ones go away for free.
+const Reduction globals = {
+  "globals",
+  [](llvm::Module &M) {
+    vector<llvm::Value*> units;
+    for (auto &GV : M.global_values()) {
+      if (auto *F = llvm::dyn_cast<llvm::Function>(&GV);
+          F && (is_src_tgt(*F) || F->isIntrinsic()))
+        continue;
+      units.emplace_back(&GV);
+    }
+    return units;
+  },
+  [](llvm::Module &M, vector<llvm::Value*> &&units) {
+    for (auto *V : units) {
+      V->replaceAllUsesWith(llvm::Constant::getNullValue(V->getType()));
+    }
+    for (auto *V : units) {
+      llvm::cast<llvm::GlobalValue>(V)->eraseFromParent();
+    }
+  }
+};
+
+}
+
+
+int main(int argc, char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::PrettyStackTraceProgram X(argc, argv);
+  llvm::EnableDebugBuffering = true;
+  llvm::llvm_shutdown_obj llvm_shutdown; // Call llvm_shutdown() on exit.
+  llvm::LLVMContext Context;
+
+  std::string Usage =
+      R"EOF(Alive2 test case reducer:
+version )EOF";
+  Usage += alive_version;
+  Usage += R"EOF(
+
+This program takes an LLVM IR file with a "src" and a "tgt" function and
+shrinks both while the verification result stays interesting: by default
+it must fail with the same error as the input; alternatively an SMT query
+must time out, or verification must take at least some time.
+
+Instructions, branches, arguments, global variables and other functions
+are removed by delta debugging. All candidates are verified in-process.
+The reduced module is written to stdout, or to the file given with -o.
+)EOF";
+
+  llvm::cl::HideUnrelatedOptions(opt_alive);
+  llvm::cl::ParseCommandLineOptions(argc, argv, Usage);
+
+  smt::set_query_timeout(to_string(opt_smt_to));
+  smt::set_memory_limit((uint64_t)opt_max_mem * 1024 * 1024);
+  config::disable_undef_input = opt_disable_undef;
+  config::disable_poison_input = opt_disable_poison;
+
+  llvm::SMDiagnostic Diag;
+  auto M = llvm::parseIRFile(opt_file, Diag, Context);
+  if (!M) {
+    Diag.print(argv[0], llvm::errs());
+    return -1;
+  }
+
+  targetTriple = llvm::Triple(M->getTargetTriple());
+
+  // don't flood the output with messages about rejected candidates
+  ostream null_os(nullptr);
+  llvm_util::initializer llvm_util_init(null_os, M->getDataLayout());
+  smt_init.emplace();
+
+  auto r = verify(*M);
+  if (!r) {
+    cerr << "ERROR: Could not verify '" << opt_src_fn << "' -> '"
+         << opt_tgt_fn << "'\n";
+    return -1;
+  }
+  cerr << "Input: " << (r->error.empty() ? "correct" : r->error) << " ("
+       << r->time.count() << " ms)\n";
+
+  input_error = move(r->error);
+  if (opt_interesting == Interesting::Same && input_error.empty()) {
+    cerr << "ERROR: The input verifies; nothing to preserve\n";
+    return -1;
+  }
+  if (!is_interesting(*M)) {
+    cerr << "ERROR: The input is not interesting\n";
+    return -1;
+  }
+
+  const Reduction reductions[] = {
+    globals, arguments, branches(false), branches(true), instructions
+  };
+
+  bool changed;
+  do {
+    changed = false;
+    for (auto &R : reductions) {
+      changed |= reduce(M, R);
+    }
+  } while (changed);
+
+  std::error_code EC;
+  llvm::raw_fd_ostream os(opt_outputfile, EC);
+  if (EC) {
+    cerr << "ERROR: Could not open '" << opt_outputfile << "': "
+         << EC.message() << '\n';
+    return -1;
+  }
+  M->print(os, nullptr);
+
+  smt_init.reset();
+  cerr << "Done after " << num_tests << " tests\n";
+  return 0;
+}
@@ -55,6 +55,11 @@ static llvm::cl::opt<bool> opt_disable_poison("disable-poison-input",
     llvm::cl::init(false), llvm::cl::cat(opt_alive),
     llvm::cl::desc("Assume inputs are not poison (default=false)"));
 
+static llvm::cl::opt<bool> opt_memory_soa("memory-soa",
+    llvm::cl::init(false), llvm::cl::cat(opt_alive),
+    llvm::cl::desc("Store data, poison and pointer bits of memory in separate "
+                   "arrays (default=false)"));
+
 static llvm::cl::opt<bool> opt_se_verbose(
     "se-verbose", llvm::cl::desc("Symbolic execution verbose mode"),
      llvm::cl::cat(opt_alive), llvm::cl::init(false));
@@ -68,6 +73,40 @@ static llvm::cl::opt<unsigned> opt_smt_random_seed(
     llvm::cl::desc("Random seed for the SMT solver (default=0)"),
     llvm::cl::init(0), llvm::cl::cat(opt_alive));
 
+static llvm::cl::opt<smt::BitCountEncoding> opt_bitcount_enc(
+    "bitcount-encoding",
+    llvm::cl::desc("SMT encoding of ctpop/ctlz/cttz (default=tree)"),
+    llvm::cl::values(
+      clEnumValN(smt::BitCountEncoding::Linear, "linear", "Chain of ites"),
+      clEnumValN(smt::BitCountEncoding::Tree, "tree",
+                 "Adder tree / binary search"),
+      clEnumValN(smt::BitCountEncoding::SWAR, "swar", "Masked adds & shifts")),
+    llvm::cl::init(smt::BitCountEncoding::Tree), llvm::cl::cat(opt_alive));
+
+static llvm::cl::opt<string> opt_smt_qfbv_solver(
+    "smt-qfbv-solver",
+    llvm::cl::desc("External SMT-LIB2 solver for quantifier-free bit-vector "
+                   "queries (default=Z3)"),
+    llvm::cl::value_desc("cmd"), llvm::cl::cat(opt_alive));
+
+static llvm::cl::opt<string> opt_smt_solver(
+    "smt-solver",
+    llvm::cl::desc("External SMT-LIB2 solver for the remaining queries "
+                   "(default=Z3)"),
+    llvm::cl::value_desc("cmd"), llvm::cl::cat(opt_alive));
+
+static llvm::cl::opt<bool> opt_smt_aig(
+    "smt-aig",
+    llvm::cl::desc("Bit-blast quantifier-free bit-vector queries into an AIG "
+                   "(default=false)"),
+    llvm::cl::init(false), llvm::cl::cat(opt_alive));
+
+static llvm::cl::opt<bool> opt_smt_aig_sweep(
+    "smt-aig-sweep",
+    llvm::cl::desc("Use SAT sweeping to merge equivalent AIG nodes "
+                   "(default=false)"),
+    llvm::cl::init(false), llvm::cl::cat(opt_alive));
+
 static llvm::cl::opt<bool> opt_smt_verbose(
     "smt-verbose", llvm::cl::desc("SMT verbose mode"),
     llvm::cl::cat(opt_alive), llvm::cl::init(false));
@@ -116,6 +155,12 @@ static llvm::cl::opt<bool> opt_smt_stats(
     "smt-stats", llvm::cl::desc("Show SMT statistics"),
     llvm::cl::cat(opt_alive), llvm::cl::init(false));
 
+static llvm::cl::opt<bool> opt_axiom_stats(
+    "axiom-stats",
+    llvm::cl::desc("Show which axioms are needed to prove refinement "
+                   "(slow; default=false)"),
+    llvm::cl::cat(opt_alive), llvm::cl::init(false));
+
 static llvm::cl::opt<bool> opt_alias_stats(
     "alias-stats", llvm::cl::desc("Show alias sets statistics"),
     llvm::cl::cat(opt_alive), llvm::cl::init(false));
@@ -434,12 +479,18 @@ convenient way to demonstrate an existing optimizer bug.
   smt::solver_tactic_verbose(opt_tactic_verbose);
   smt::set_query_timeout(to_string(opt_smt_to));
   smt::set_random_seed(to_string(opt_smt_random_seed));
+  smt::set_bitcount_encoding(opt_bitcount_enc);
+  smt::solver_set_external(smt::QueryClass::QF_BV, opt_smt_qfbv_solver);
+  smt::solver_set_external(smt::QueryClass::Other, opt_smt_solver);
+  smt::solver_set_aig(opt_smt_aig || opt_smt_aig_sweep, opt_smt_aig_sweep);
   smt::set_memory_limit((uint64_t)opt_max_mem * 1024 * 1024);
   config::skip_smt = opt_smt_skip;
   config::io_nobuiltin = opt_io_nobuiltin;
   config::symexec_print_each_value = opt_se_verbose;
   config::disable_undef_input = opt_disable_undef;
   config::disable_poison_input = opt_disable_poison;
+  config::memory_soa = opt_memory_soa;
+  config::axiom_stats = opt_axiom_stats;
   config::debug = opt_debug;
 
   if (opt_smt_log)
@@ -518,6 +569,8 @@ convenient way to demonstrate an existing optimizer bug.
 end:
   if (opt_smt_stats)
     smt::solver_print_stats(cout);
+  if (opt_axiom_stats)
+    print_axiom_stats(cout);
 
   smt_init.reset();
 
@@ -28,8 +28,15 @@ static void show_help() {
           " -root-only\t\tCheck the expression's root only\n"
           " -v\t\t\tVerbose mode\n"
           " -smt-stats\t\tShow SMT statistics\n"
+          " -axiom-stats\t\tShow which axioms are needed by proofs\n"
           " -smt-to:x\t\tTimeout for SMT queries in ms\n"
           " -smt-random-seed:x\tRandom seed for the SMT solver\n"
+          " -bitcount-encoding:x\tEncoding of ctpop/ctlz/cttz:"
+          " linear, tree, swar\n"
+          " -smt-qfbv-solver:cmd\tExternal solver for QF_BV queries\n"
+          " -smt-solver:cmd\tExternal solver for the remaining queries\n"
+          " -smt-aig\t\tBit-blast QF_BV queries into an AIG\n"
+          " -smt-aig-sweep\t\tBit-blast into an AIG and use SAT sweeping\n"
           " -max-mem:x\t\tMax memory consumption in MB (aprox)\n"
           " -smt-verbose\t\tPrint all SMT queries\n"
           " -tactic-verbose\tDebug SMT tactics\n"
@@ -58,10 +65,27 @@ int main(int argc, char **argv) {
       verbose = true;
     else if (arg == "-smt-stats")
       show_smt_stats = true;
+    else if (arg == "-axiom-stats")
+      config::axiom_stats = true;
     else if (arg.compare(0, 8, "-smt-to:") == 0 && arg.size() > 8)
       smt::set_query_timeout(arg.substr(8).data());
     else if (arg.compare(0, 17, "-smt-random-seed:") == 0 && arg.size() > 17)
       smt::set_random_seed(arg.substr(17).data());
+    else if (arg == "-bitcount-encoding:linear")
+      smt::set_bitcount_encoding(smt::BitCountEncoding::Linear);
+    else if (arg == "-bitcount-encoding:tree")
+      smt::set_bitcount_encoding(smt::BitCountEncoding::Tree);
+    else if (arg == "-bitcount-encoding:swar")
+      smt::set_bitcount_encoding(smt::BitCountEncoding::SWAR);
+    else if (arg.compare(0, 17, "-smt-qfbv-solver:") == 0 && arg.size() > 17)
+      smt::solver_set_external(smt::QueryClass::QF_BV,
+                               string(arg.substr(17)));
+    else if (arg.compare(0, 12, "-smt-solver:") == 0 && arg.size() > 12)
+      smt::solver_set_external(smt::QueryClass::Other, string(arg.substr(12)));
+    else if (arg == "-smt-aig")
+      smt::solver_set_aig(true);
+    else if (arg == "-smt-aig-sweep")
+      smt::solver_set_aig(true, true);
     else if (arg.compare(0, 9, "-max-mem:") == 0 && arg.size() > 9)
       smt::set_memory_limit(strtoul(arg.substr(9).data(), nullptr, 10) *
                             1024 * 1024);
@@ -150,6 +174,8 @@ int main(int argc, char **argv) {
 
   if (show_smt_stats)
     smt::solver_print_stats(cout);
+  if (config::axiom_stats)
+    print_axiom_stats(cout);
 
   return 0;
 }
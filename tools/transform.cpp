@@ -12,10 +12,12 @@
 #include "util/stopwatch.h"
 #include "util/symexec.h"
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <set>
 #include <sstream>
+#include <unordered_map>
 
 using namespace IR;
 using namespace smt;
@@ -24,9 +26,43 @@ using namespace util;
 using namespace std;
 
 
+// Cheap sufficient check for is_arbitrary: e is an invertible function of a
+// variable, possibly guarded by a condition on other variables.
+static bool is_invertible_var(const expr &e) {
+  if (e.isVar())
+    return true;
+
+  expr a, b, c;
+  uint64_t n;
+  if (e.isAdd(a, b))
+    return (a.isConst() && is_invertible_var(b)) ||
+           (b.isConst() && is_invertible_var(a));
+  if (e.isMul(a, b))
+    return (a.isUInt(n) && (n & 1) && is_invertible_var(b)) ||
+           (b.isUInt(n) && (n & 1) && is_invertible_var(a));
+
+  // both ite(v, ..) and ite(v == k, ..) can take either branch
+  if (e.isIf(c, a, b)) {
+    expr lhs, rhs;
+    if (c.isNot(lhs))
+      c = lhs;
+    if (c.isEq(lhs, rhs) && (lhs.isConst() || rhs.isConst()))
+      c = lhs.isConst() ? rhs : lhs;
+    if (!c.isVar())
+      return false;
+    auto disjoint = [&](const expr &branch) {
+      return !branch.vars().count(c) && is_invertible_var(branch);
+    };
+    return disjoint(a) || disjoint(b);
+  }
+  return false;
+}
+
 static bool is_arbitrary(const expr &e) {
   if (e.isConst())
     return false;
+  if (is_invertible_var(e))
+    return true;
   return check_expr(expr::mkForAll(e.vars(), expr::mkVar("#someval", e) != e)).
            isUnsat();
 }
@@ -193,34 +229,36 @@ void tools::error(Errors &errs, State &src_state, State &tgt_state,
 
 
 
-static void instantiate_undef(const Input *in, map<expr, expr> &instances,
-                              map<expr, expr> &instances2, const Type &ty,
-                              unsigned child) {
+static void collect_undef_vars(const Input &in, const Type &ty,
+                               unsigned child, vector<expr> &vars) {
   if (auto agg = ty.getAsAggregateType()) {
     for (unsigned i = 0, e = agg->numElementsConst(); i < e; ++i) {
       if (!agg->isPadding(i))
-        instantiate_undef(in, instances, instances2, agg->getChild(i),
-                          child + i);
+        collect_undef_vars(in, agg->getChild(i), child + i, vars);
     }
     return;
   }
 
-  // Bail out if it gets too big. It's unlikely we can solve it anyway.
-  if (instances.size() >= 128 || hit_half_memory_limit())
-    return;
-
-  auto var = in->getUndefVar(ty, child);
-  if (!var.isValid())
-    return;
-
-  // TODO: add support for per-bit input undef
-  assert(var.bits() == 1);
+  if (auto var = in.getUndefVar(ty, child); var.isValid())
+    vars.emplace_back(move(var));
+}
 
+// Case splits on bit 'bit' of the undef mask 'var'.
+static void instantiate_undef(map<expr, expr> &instances, const expr &var,
+                              unsigned bit) {
+  unsigned bits = var.bits();
   expr nums[2] = { expr::mkUInt(0, 1), expr::mkUInt(1, 1) };
+  map<expr, expr> instances2;
 
   for (auto &[e, v] : instances) {
     for (unsigned i = 0; i < 2; ++i) {
-      expr newexpr = e.subst(var, nums[i]);
+      expr val = nums[i];
+      if (bit + 1 < bits)
+        val = var.extract(bits - 1, bit + 1).concat(val);
+      if (bit > 0)
+        val = val.concat(var.extract(bit - 1, 0));
+
+      expr newexpr = e.subst(var, val);
       if (newexpr.eq(e)) {
         instances2[move(newexpr)] = v;
         break;
@@ -231,12 +269,52 @@ static void instantiate_undef(const Input *in, map<expr, expr> &instances,
         continue;
 
       // keep 'var' variables for counterexample printing
-      instances2.try_emplace(move(newexpr), v && var == nums[i]);
+      instances2.try_emplace(move(newexpr),
+                             v && var.extract(bit, bit) == nums[i]);
     }
   }
   instances = move(instances2);
 }
 
+// Bail out if the instances get too big. It's unlikely we can solve them
+// anyway. Up to min_undef_insts instances are allowed regardless of size.
+static const unsigned max_undef_inst_nodes = 1u << 18;
+static const unsigned min_undef_insts = 128;
+
+// Instantiates the undef masks of the inputs one bit at a time, starting
+// with the masks that most of the formula depends on, until the estimated
+// size of the instances gets too big.
+static void instantiate_undef(Transform &t, map<expr, expr> &instances) {
+  vector<expr> vars;
+  for (auto &i : t.src.getInputs()) {
+    if (auto in = dynamic_cast<const Input*>(&i))
+      collect_undef_vars(*in, i.getType(), 0, vars);
+  }
+
+  auto &e = instances.begin()->first;
+  if (!e.isValid())
+    return;
+
+  auto [nodes, deps] = e.subtermStats(vars);
+  vector<unsigned> order;
+  for (unsigned i = 0, ie = vars.size(); i != ie; ++i) {
+    if (deps[i] != 0)
+      order.emplace_back(i);
+  }
+  stable_sort(order.begin(), order.end(),
+              [&](unsigned a, unsigned b) { return deps[a] > deps[b]; });
+
+  for (auto i : order) {
+    for (unsigned bit = 0, be = vars[i].bits(); bit != be; ++bit) {
+      if ((instances.size() >= min_undef_insts &&
+           uint64_t(instances.size()) * 2 * nodes > max_undef_inst_nodes) ||
+          hit_half_memory_limit())
+        return;
+      instantiate_undef(instances, vars[i], bit);
+    }
+  }
+}
+
 expr tools::preprocess(Transform &t, const set<expr> &qvars0,
                 const set<expr> &undef_qvars, expr && e) {
   if (hit_half_memory_limit())
@@ -269,12 +347,7 @@ expr tools::preprocess(Transform &t, const set<expr> &qvars0,
 
   // manually instantiate undef masks
   map<expr, expr> instances({ { move(e), true } });
-  map<expr, expr> instances2;
-
-  for (auto &i : t.src.getInputs()) {
-    if (auto in = dynamic_cast<const Input*>(&i))
-      instantiate_undef(in, instances, instances2, i.getType(), 0);
-  }
+  instantiate_undef(t, instances);
 
   expr insts(false);
   for (auto &[e, v] : instances) {
@@ -332,6 +405,59 @@ static expr encode_undef_refinement(const Type &type, const State::ValTy &a,
                                           expr(b.first.value), subst(b));
 }
 
+namespace {
+struct AxiomStat {
+  unsigned present = 0; // # of proofs that had axioms of this kind
+  unsigned used = 0;    // # of proofs whose unsat core needed them
+};
+}
+
+static map<string, AxiomStat> axiom_stats;
+static unsigned num_cores = 0, num_cores_failed = 0;
+
+// Proves fml unsat again with each group of axioms guarded by an assumption
+// literal, and records which groups were in the unsat core.
+static void record_axiom_usage(const map<string, AndExpr> &groups,
+                               const expr &fml) {
+  Solver s(true);
+  vector<expr> lits;
+  for (auto &[kind, axioms] : groups) {
+    if (axioms.isTrue())
+      continue;
+    auto lit = expr::mkFreshVar(("#axiom_" + kind).c_str(), false);
+    s.add(lit.implies(axioms()));
+    lits.emplace_back(move(lit));
+  }
+  s.add(fml);
+
+  vector<expr> core;
+  if (!s.checkCore(lits, core).isUnsat()) {
+    ++num_cores_failed;
+    return;
+  }
+  ++num_cores;
+
+  set<expr> used(core.begin(), core.end());
+  unsigned i = 0;
+  for (auto &[kind, axioms] : groups) {
+    if (axioms.isTrue())
+      continue;
+    auto &stat = axiom_stats[kind];
+    ++stat.present;
+    stat.used += used.count(lits[i++]);
+  }
+}
+
+void tools::print_axiom_stats(ostream &os) {
+  os << "\n------------------ AXIOM STATS ------------------\n"
+        "Num unsat cores: " << num_cores << "\n"
+        "Num failed:      " << num_cores_failed << '\n';
+  for (auto &[kind, stat] : axiom_stats) {
+    os << kind << ": used in " << stat.used << " of " << stat.present
+       << " proofs\n";
+  }
+}
+
 static void
 check_refinement(Errors &errs, Transform &t, State &src_state, State &tgt_state,
                  const Value *var, const Type &type,
@@ -399,8 +525,8 @@ check_refinement(Errors &errs, Transform &t, State &src_state, State &tgt_state,
   auto [poison_cnstr, value_cnstr] = type.refines(src_state, tgt_state, a, b);
   expr undef_cnstr = encode_undef_refinement(type, ap, bp);
 
-  auto src_mem = src_state.returnMemory();
-  auto tgt_mem = tgt_state.returnMemory();
+  auto &src_mem = src_state.returnMemory();
+  auto &tgt_mem = tgt_state.returnMemory();
   auto [memory_cnstr0, ptr_refinement0, mem_undef]
     = src_mem.refined(tgt_mem, false);
   auto &ptr_refinement = ptr_refinement0;
@@ -408,12 +534,86 @@ check_refinement(Errors &errs, Transform &t, State &src_state, State &tgt_state,
                                              : value_cnstr && memory_cnstr0;
   qvars.insert(mem_undef.begin(), mem_undef.end());
 
+  // Abstract the subterms shared by the source and target values into fresh
+  // variables. The abstracted queries have more models, so if they are unsat
+  // the original ones are too. Otherwise, we fall back to the originals.
+  // Only bit-vector terms are abstracted: shared boolean terms rarely simplify
+  // much, and abstracting memory arrays makes the queries much harder.
+  // Equal terms with different shapes in src and tgt share the same variable.
+  vector<pair<expr, expr>> shared;
+  for (auto &[ea, eb] : expr::commonSubterms({ &a.value, &a.non_poison },
+                                             { &b.value, &b.non_poison },
+                                             qvars)) {
+    if (!eb.isBV())
+      continue;
+    auto var = expr::mkFreshVar("#shared", eb);
+    if (!ea.eq(eb))
+      shared.emplace_back(ea, var);
+    shared.emplace_back(eb, move(var));
+  }
+
+  // Instantiate the nondet vars of src freezes with the value of the
+  // homonymous tgt instruction. Instantiating a universally quantified var
+  // only weakens the formula, so the same argument as above applies.
+  vector<pair<expr, expr>> nondet_insts;
+  if (!src_state.getFreezeVars().empty()) {
+    unordered_map<string, const State::ValTy*> tgt_vals;
+    for (auto &[var, val, used] : tgt_state.getValues()) {
+      (void)used;
+      tgt_vals.emplace(var->getName(), &val);
+    }
+
+    for (auto &[nondet, p] : src_state.getFreezeVars()) {
+      auto &[val, idx] = p;
+      auto I = tgt_vals.find(val->getName());
+      if (I == tgt_vals.end() || !qvars.count(nondet))
+        continue;
+
+      expr inst = I->second->first.value;
+      if (auto agg = val->getType().getAsAggregateType())
+        inst = agg->extract(I->second->first, idx).value;
+      if (inst.isValid() && inst.isSameSort(nondet))
+        nondet_insts.emplace_back(nondet, move(inst));
+    }
+  }
+
+  // Likewise, instantiate the NaN payloads of src float to int conversions
+  // with those of tgt, matched in order of creation. When the conversions
+  // correspond, the query becomes quantifier-free.
+  {
+    auto &tgt_nans = tgt_state.getNaNVars();
+    vector<bool> used(tgt_nans.size());
+    for (auto &nan : src_state.getNaNVars()) {
+      if (!qvars.count(nan))
+        continue;
+      for (unsigned i = 0, e = tgt_nans.size(); i != e; ++i) {
+        if (!used[i] && tgt_nans[i].isSameSort(nan)) {
+          used[i] = true;
+          nondet_insts.emplace_back(nan, tgt_nans[i]);
+          break;
+        }
+      }
+    }
+  }
+
+  auto qvars_inst = qvars;
+  for (auto &[var, inst] : nondet_insts) {
+    qvars_inst.erase(var);
+  }
+
   if (check_expr(axioms_expr && (pre_src && pre_tgt)).isUnsat()) {
     errs.add("Precondition is always false", false);
     return;
   }
 
-  auto mk_fml = [&](expr &&refines) -> expr {
+  unsigned weaker_timeout
+    = max(1ul, strtoul(get_query_timeout(), nullptr, 10) / 40);
+
+  vector<expr> proved; // for axiom statistics
+  // The formulas are built upfront, but the weaker query is only checked once
+  // the query is reached
+  auto mk_fml = [&](expr &&refines, bool abstract_shared = false)
+                  -> function<expr()> {
     // from the check above we already know that
     // \exists v,v' . pre_tgt(v') && pre_src(v) is SAT (or timeout)
     // so \forall v . pre_tgt && (!pre_src(v) || refines) simplifies to:
@@ -421,19 +621,44 @@ check_refinement(Errors &errs, Transform &t, State &src_state, State &tgt_state,
     // \forall v . (pre_tgt && !pre_src(v)) ->  [\exists v . pre_src(v)]
     // false
     if (refines.isFalse())
-      return move(refines);
+      return [] { return expr(false); };
 
-    return axioms_expr &&
-            preprocess(t, qvars, uvars, pre && pre_src_forall.implies(refines));
+    if (config::axiom_stats)
+      proved.emplace_back(refines);
+
+    expr fml = axioms_expr &&
+               preprocess(t, qvars, uvars,
+                          pre && pre_src_forall.implies(refines));
+
+    expr weaker = fml;
+    if (!nondet_insts.empty()) {
+      auto body = pre && pre_src_forall.implies(refines);
+      auto inst = body.subst(nondet_insts);
+      if (!inst.eq(body))
+        weaker = axioms_expr && preprocess(t, qvars_inst, uvars, move(inst));
+    }
+    if (abstract_shared && !shared.empty())
+      weaker = weaker.subst(shared);
+
+    // The weaker query is usually much easier when it is unsat, so don't
+    // waste the whole budget on it.
+    return [=]() {
+      if (!weaker.eq(fml) &&
+          check_expr(weaker, weaker_timeout).isUnsat())
+        return expr(false);
+      return fml;
+    };
   };
 
   auto print_ptr_load = [&](ostream &s, const Model &m) {
+    // loads update the alias info, so don't touch the states' memories
+    auto src_m = src_mem, tgt_m = tgt_mem;
     set<expr> undef;
-    Pointer p(src_mem, m[ptr_refinement()]);
+    Pointer p(src_m, m[ptr_refinement()]);
     unsigned align = bits_byte / 8;
     s << "\nMismatch in " << p
-      << "\nSource value: " << Byte(src_mem, m[src_mem.load(p, undef, align)()])
-      << "\nTarget value: " << Byte(tgt_mem, m[tgt_mem.load(p, undef, align)()]);
+      << "\nSource value: " << Byte(src_m, m[src_m.load(p, undef, align)()])
+      << "\nTarget value: " << Byte(tgt_m, m[tgt_m.load(p, undef, align)()]);
   };
 
   expr dom_constr;
@@ -459,15 +684,15 @@ check_refinement(Errors &errs, Transform &t, State &src_state, State &tgt_state,
         err(r, [](ostream&, const Model&){},
             "Source and target don't have the same return domain");
       }},
-    { mk_fml(dom && !poison_cnstr),
+    { mk_fml(dom && !poison_cnstr, true),
       [&](const Result &r) {
         err(r, print_value, "Target is more poisonous than source");
       }},
-    { mk_fml(dom && undef_cnstr),
+    { mk_fml(dom && undef_cnstr, true),
       [&](const Result &r) {
         err(r, print_value, "Target's return value is more undefined");
       }},
-    { mk_fml(dom && !value_cnstr),
+    { mk_fml(dom && !value_cnstr, true),
       [&](const Result &r) {
         err(r, print_value, "Value mismatch");
       }},
@@ -476,6 +701,25 @@ check_refinement(Errors &errs, Transform &t, State &src_state, State &tgt_state,
         err(r, print_ptr_load, "Mismatch in memory");
       }}
   });
+
+  if (config::axiom_stats && !errs) {
+    map<string, AndExpr> groups;
+    for (auto *st : { &src_state, &tgt_state }) {
+      for (auto &[kind, axioms] : st->getAxiomsByKind()) {
+        groups[kind].add(axioms);
+      }
+    }
+    // The preconditions of function calls are only assumed under the
+    // quantifier, so they can never be needed for unsat.
+    groups["pre-src"].add(pre_src_exists);
+    groups["pre-tgt"].add(pre_tgt);
+
+    for (auto &refines : proved) {
+      record_axiom_usage(groups,
+                         preprocess(t, qvars, uvars,
+                                    pre_src_forall.implies(refines)));
+    }
+  }
 }
 
 static bool has_nullptr(const Value *v) {
@@ -617,7 +861,8 @@ static void calculateAndInitConstants(Transform &t) {
   num_ptrinputs = 0;
   for (auto &arg : t.src.getInputs()) {
     auto n = num_ptrs(arg.getType());
-    if (dynamic_cast<const Input*>(&arg)->hasAttribute(ParamAttrs::ByVal)) {
+    auto in = dynamic_cast<const Input*>(&arg);
+    if (in && in->hasAttribute(ParamAttrs::ByVal)) {
       num_globals_src += n;
       num_globals += n;
     } else
@@ -729,6 +974,8 @@ static void calculateAndInitConstants(Transform &t) {
             has_malloc |= dynamic_cast<const Malloc*>(&i) != nullptr ||
                           dynamic_cast<const Calloc*>(&i) != nullptr;
           }
+          // memchr & strchr return null if the char is not found
+          nullptr_is_used |= dynamic_cast<const Memchr*>(&i) != nullptr;
 
         } else if (isCast(ConversionOp::Int2Ptr, i) ||
                    isCast(ConversionOp::Ptr2Int, i)) {
@@ -883,6 +1130,14 @@ TransformVerify::TransformVerify(Transform &t, bool check_each_var) :
 }
 
 Errors TransformVerify::verify() const {
+  // The transformation holds trivially for typings where the precondition is
+  // known to be false
+  if (t.precondition) {
+    auto pre = t.precondition->eval();
+    if (pre && !*pre)
+      return {};
+  }
+
   if (t.src.getFnAttrs() != t.tgt.getFnAttrs() ||
       !t.src.hasSameInputs(t.tgt)) {
     return { "Unsupported interprocedural transformation: signature mismatch "
@@ -964,9 +1219,9 @@ Errors TransformVerify::verify() const {
   }
 
   check_refinement(errs, t, src_state, tgt_state, nullptr, t.src.getType(),
-                   src_state.returnDomain()(), src_state.functionDomain()(),
+                   src_state.returnDomain(), src_state.functionDomain(),
                    src_state.returnVal(),
-                   tgt_state.returnDomain()(), tgt_state.functionDomain()(),
+                   tgt_state.returnDomain(), tgt_state.functionDomain(),
                    tgt_state.returnVal(),
                    check_each_var);
 
@@ -1041,24 +1296,43 @@ static map<string_view, Instr*> can_remove_init(Function &fn) {
     }
   }
 
+  // gvar -> store of its initializer
+  map<const Value*, Instr*> init_stores;
+  set<const Value*> init_store_instrs;
+  for (auto &i : bb.instrs()) {
+    if (dynamic_cast<const Store*>(&i)) {
+      init_stores.emplace(i.operands()[1], const_cast<Instr*>(&i));
+      init_store_instrs.emplace(&i);
+    }
+  }
+
+  // The initializer of a global is needed if the function may observe the
+  // global, or if its address is stored in the initializer of a global whose
+  // initializer is needed.
+  set<const Value*> needed;
+  multimap<const Value*, const Value*> stored_gvars; // gvar -> stored gvars
+
   vector<Value*> worklist;
   set<const Value*> seen;
   auto users = fn.getUsers();
 
-  for (auto &i : bb.instrs()) {
-    if (!dynamic_cast<const Store*>(&i))
-      continue;
-    auto gvar = i.operands()[1];
-    worklist.emplace_back(gvar);
-    seen.emplace(&i);
+  for (auto &[gvar, store] : init_stores) {
+    worklist.emplace_back(const_cast<Value*>(gvar));
+    seen.emplace(store);
 
-    bool needed = false;
+    bool is_needed = false;
     do {
       auto user = worklist.back();
       worklist.pop_back();
       if (!seen.emplace(user).second)
         continue;
 
+      // stored in the initializer of another global
+      if (init_store_instrs.count(user)) {
+        stored_gvars.emplace(static_cast<Instr*>(user)->operands()[1], gvar);
+        continue;
+      }
+
       // OK, we can't observe which memory it reads
       if (dynamic_cast<FnCall*>(user))
         continue;
@@ -1066,7 +1340,7 @@ static map<string_view, Instr*> can_remove_init(Function &fn) {
       if (isCast(ConversionOp::Ptr2Int, *user)) {
         // int2ptr can potentially alias with anything, so play on the safe side
         if (has_int2ptr) {
-          needed = true;
+          is_needed = true;
           break;
         }
         continue;
@@ -1074,7 +1348,7 @@ static map<string_view, Instr*> can_remove_init(Function &fn) {
 
       // if (p == @const) read(load p) ; this should read @const (or raise UB)
       if (dynamic_cast<ICmp*>(user)) {
-        needed = true;
+        is_needed = true;
         break;
       }
 
@@ -1083,7 +1357,7 @@ static map<string_view, Instr*> can_remove_init(Function &fn) {
         continue;
 
       if (dynamic_cast<MemInstr*>(user) && !dynamic_cast<GEP*>(user)) {
-        needed = true;
+        is_needed = true;
         break;
       }
 
@@ -1095,8 +1369,24 @@ static map<string_view, Instr*> can_remove_init(Function &fn) {
     worklist.clear();
     seen.clear();
 
-    if (!needed)
-      to_remove.emplace(gvar->getName(), const_cast<Instr*>(&i));
+    if (is_needed)
+      needed.emplace(gvar);
+  }
+
+  vector<const Value*> todo(needed.begin(), needed.end());
+  while (!todo.empty()) {
+    auto gvar = todo.back();
+    todo.pop_back();
+    for (auto p = stored_gvars.equal_range(gvar); p.first != p.second;
+         ++p.first) {
+      if (needed.emplace(p.first->second).second)
+        todo.emplace_back(p.first->second);
+    }
+  }
+
+  for (auto &[gvar, store] : init_stores) {
+    if (!needed.count(gvar))
+      to_remove.emplace(gvar->getName(), store);
   }
   return to_remove;
 }
@@ -62,6 +62,11 @@ smt::expr preprocess(Transform &t, const std::set<smt::expr> &qvars0,
                 const std::set<smt::expr> &undef_qvars, smt::expr && e);
 
 
+// statistics of the axioms needed by refinement proofs
+// (with config::axiom_stats)
+void print_axiom_stats(std::ostream &os);
+
+
 using print_var_val_ty = std::function<void(std::ostream&, const smt::Model&)>;
 
 void error(util::Errors &errs, IR::State &src_state, IR::State &tgt_state,
@@ -2,6 +2,7 @@
 // Distributed under the MIT license that can be found in the LICENSE file.
 
 #include "llvm_util/llvm2alive.h"
+#include "llvm_util/utils.h"
 #include "ir/memory.h"
 #include "smt/smt.h"
 #include "smt/solver.h"
@@ -11,15 +12,21 @@
 #include "llvm/ADT/Any.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include <fstream>
 #include <iostream>
+#include <list>
 #include <random>
 #include <unordered_map>
 #include <utility>
@@ -53,10 +60,51 @@ llvm::cl::opt<unsigned> opt_smt_random_seed(
   llvm::cl::desc("Alive: Random seed for the SMT solver (default=0)"),
   llvm::cl::init(0));
 
+llvm::cl::opt<smt::BitCountEncoding> opt_bitcount_enc(
+  "tv-bitcount-encoding",
+  llvm::cl::desc("Alive: SMT encoding of ctpop/ctlz/cttz (default=tree)"),
+  llvm::cl::values(
+    clEnumValN(smt::BitCountEncoding::Linear, "linear", "Chain of ites"),
+    clEnumValN(smt::BitCountEncoding::Tree, "tree",
+               "Adder tree / binary search"),
+    clEnumValN(smt::BitCountEncoding::SWAR, "swar", "Masked adds & shifts")),
+  llvm::cl::init(smt::BitCountEncoding::Tree));
+
+llvm::cl::opt<string> opt_smt_qfbv_solver(
+  "tv-smt-qfbv-solver",
+  llvm::cl::desc("Alive: external SMT-LIB2 solver for quantifier-free "
+                 "bit-vector queries (default=Z3)"),
+  llvm::cl::value_desc("cmd"));
+
+llvm::cl::opt<string> opt_smt_solver(
+  "tv-smt-solver",
+  llvm::cl::desc("Alive: external SMT-LIB2 solver for the remaining queries "
+                 "(default=Z3)"),
+  llvm::cl::value_desc("cmd"));
+
+llvm::cl::opt<bool> opt_smt_aig(
+  "tv-smt-aig",
+  llvm::cl::desc("Alive: bit-blast quantifier-free bit-vector queries into "
+                 "an AIG"),
+  llvm::cl::init(false));
+
+llvm::cl::opt<bool> opt_smt_aig_sweep(
+  "tv-smt-aig-sweep",
+  llvm::cl::desc("Alive: use SAT sweeping to merge equivalent AIG nodes"),
+  llvm::cl::init(false));
+
 llvm::cl::opt<unsigned> opt_max_mem(
   "tv-max-mem", llvm::cl::desc("Alive: max memory (aprox)"),
   llvm::cl::init(1024), llvm::cl::value_desc("MB"));
 
+llvm::cl::opt<unsigned> opt_saved_fns_mem(
+  "tv-saved-fns-mem",
+  llvm::cl::desc("Alive: max memory (aprox) for the functions kept between "
+                 "passes; the least recently used ones are spilled to disk "
+                 "and retranslated when needed, which doesn't change the "
+                 "results (default=0, unlimited)"),
+  llvm::cl::init(0), llvm::cl::value_desc("KB"));
+
 llvm::cl::opt<bool> opt_se_verbose(
   "tv-se-verbose", llvm::cl::desc("Alive: symbolic execution verbose mode"),
   llvm::cl::init(false));
@@ -65,6 +113,11 @@ llvm::cl::opt<bool> opt_smt_stats(
   "tv-smt-stats", llvm::cl::desc("Alive: show SMT statistics"),
   llvm::cl::init(false));
 
+llvm::cl::opt<bool> opt_axiom_stats(
+  "tv-axiom-stats",
+  llvm::cl::desc("Alive: show which axioms are needed to prove refinement"),
+  llvm::cl::init(false));
+
 llvm::cl::opt<bool> opt_alias_stats(
   "tv-alias-stats", llvm::cl::desc("Alive: show alias sets statistics"),
   llvm::cl::init(false));
@@ -103,6 +156,12 @@ llvm::cl::opt<bool> opt_disable_undef_input(
   llvm::cl::desc("Alive: Assume function input cannot be undef"),
   llvm::cl::init(false));
 
+llvm::cl::opt<bool> opt_memory_soa(
+  "tv-memory-soa",
+  llvm::cl::desc("Alive: Store data, poison and pointer bits of memory in "
+                 "separate arrays"),
+  llvm::cl::init(false));
+
 llvm::cl::list<std::string> opt_funcs(
   "tv-func",
   llvm::cl::desc("Name of functions to verify (without @)"),
@@ -130,7 +189,26 @@ string report_filename;
 optional<smt::smt_initializer> smt_init;
 optional<llvm_util::initializer> llvm_util_init;
 TransformPrintOpts print_opts;
-unordered_map<string, pair<Function, unsigned>> fns;
+
+struct SavedFn {
+  optional<Function> fn; // empty while spilled to disk
+  unsigned dot_count = 0;
+  size_t size = 0;       // estimated size of fn in bytes
+  size_t ir_hash = 0;    // hash of the LLVM IR fn was translated from
+  string spill_file;     // bitcode snapshot of the LLVM IR while spilled
+  vector<string> gvnames;
+  list<string>::iterator lru;
+};
+
+unordered_map<string, SavedFn> fns;
+list<string> fns_lru; // in-memory functions, most recently used first
+size_t fns_size = 0;
+unsigned num_spilled = 0;
+unsigned num_reloaded = 0;
+unsigned num_reload_failed = 0;
+// Owns the modules reloaded from disk. Their translations don't outlive a
+// run of the pass, so it's freed once the last pass instance is finalized.
+unique_ptr<llvm::LLVMContext> reload_ctx;
 set<string> fnsToVerify;
 unsigned initialized = 0;
 bool showed_stats = false;
@@ -139,6 +217,126 @@ bool has_failure = false;
 bool is_clangtv = false;
 
 
+size_t hash_ir(const llvm::Function &F) {
+  string str;
+  llvm::raw_string_ostream os(str);
+  F.print(os);
+  return hash<string>()(os.str());
+}
+
+// Writes a module with just F's definition (plus the initializers of constant
+// globals, which llvm2alive looks into) to a temporary file and drops the
+// translated function.
+bool spill_fn(llvm::Module &M, const string &name, SavedFn &saved) {
+  // A pass may have changed F since it was translated
+  auto *F = M.getFunction(name);
+  if (!F || F->isDeclaration() || hash_ir(*F) != saved.ir_hash)
+    return false;
+
+  llvm::ValueToValueMapTy vmap;
+  auto snapshot = llvm::CloneModule(M, vmap, [&](const llvm::GlobalValue *gv) {
+    auto *var = llvm::dyn_cast<llvm::GlobalVariable>(gv);
+    return gv == F || (var && var->isConstant());
+  });
+
+  int fd;
+  llvm::SmallString<128> path;
+  if (llvm::sys::fs::createTemporaryFile("alive-tv", "bc", fd, path))
+    return false;
+
+  llvm::raw_fd_ostream os(fd, true);
+  llvm::WriteBitcodeToFile(*snapshot, os);
+  os.close();
+  if (os.has_error()) {
+    os.clear_error();
+    llvm::sys::fs::remove(path);
+    return false;
+  }
+
+  saved.spill_file = path.str().str();
+  saved.gvnames.clear();
+  for (auto gvname : saved.fn->getGlobalVarNames()) {
+    saved.gvnames.emplace_back(gvname);
+  }
+  saved.fn.reset();
+  fns_size -= saved.size;
+  saved.size = 0;
+  ++num_spilled;
+  return true;
+}
+
+// Retranslates a spilled function with the pass' TLI, so that libcalls are
+// recognized exactly as in the function it's compared against.
+bool reload_fn(const string &name, SavedFn &saved,
+               const llvm::TargetLibraryInfo &TLI) {
+  if (!reload_ctx)
+    reload_ctx = make_unique<llvm::LLVMContext>();
+
+  auto buf = llvm::MemoryBuffer::getFile(saved.spill_file);
+  llvm::sys::fs::remove(saved.spill_file);
+  saved.spill_file.clear();
+  if (!buf)
+    return false;
+
+  auto M = llvm::parseBitcodeFile((*buf)->getMemBufferRef(), *reload_ctx);
+  if (!M) {
+    llvm::consumeError(M.takeError());
+    return false;
+  }
+
+  auto *F = (*M)->getFunction(name);
+  if (!F)
+    return false;
+
+  saved.fn = llvm2alive(*F, TLI, { saved.gvnames.begin(),
+                                   saved.gvnames.end() });
+  if (!saved.fn)
+    return false;
+
+  ++num_reloaded;
+  return true;
+}
+
+// Records that 'saved' now holds the translation of F, and spills the least
+// recently used functions if over the memory budget.
+void save_fn(const llvm::Function &F, SavedFn &saved) {
+  if (!opt_saved_fns_mem)
+    return;
+
+  fns_size -= saved.size;
+  saved.size = size_t(F.getInstructionCount() + 1) * 256;
+  fns_size += saved.size;
+  saved.ir_hash = hash_ir(F);
+
+  if (saved.lru != fns_lru.end())
+    fns_lru.erase(saved.lru);
+  saved.lru = fns_lru.emplace(fns_lru.begin(), F.getName().str());
+
+  size_t budget = size_t(opt_saved_fns_mem) * 1024;
+  auto &M = const_cast<llvm::Module&>(*F.getParent());
+  auto I = fns_lru.end();
+  while (fns_size > budget && I != fns_lru.begin()) {
+    auto &candidate = fns.at(*--I);
+    if (&candidate == &saved)
+      continue;
+    if (spill_fn(M, *I, candidate)) {
+      candidate.lru = fns_lru.end();
+      I = fns_lru.erase(I);
+    }
+  }
+}
+
+void forget_fn(decltype(fns)::iterator I) {
+  auto &saved = I->second;
+  if (saved.lru != fns_lru.end())
+    fns_lru.erase(saved.lru);
+  if (!saved.spill_file.empty())
+    llvm::sys::fs::remove(saved.spill_file);
+  fns_size -= saved.size;
+  fns.erase(I);
+}
+
+
 struct TVPass final : public llvm::FunctionPass {
   static char ID;
 
@@ -166,33 +364,46 @@ struct TVPass final : public llvm::FunctionPass {
     }
 
     auto [I, first] = fns.try_emplace(F.getName().str());
+    auto &saved = I->second;
+    if (first)
+      saved.lru = fns_lru.end();
+    else if (!saved.fn && !reload_fn(I->first, saved, *TLI)) {
+      // snapshot is gone; start over from this version of the function
+      *out << "Skipping " << I->first << ": couldn't reload the version "
+              "spilled to disk; the transformation was not verified\n\n";
+      ++num_reload_failed;
+      first = true;
+    }
+
     auto fn = llvm2alive(F, *TLI, first ? vector<string_view>()
-                                        : I->second.first.getGlobalVarNames());
+                                        : saved.fn->getGlobalVarNames());
     if (!fn) {
-      fns.erase(I);
+      forget_fn(I);
       return false;
     }
 
-    auto old_fn = move(I->second.first);
-    I->second.first = move(*fn);
+    auto old_fn = move(saved.fn);
+    saved.fn = move(*fn);
 
     if (opt_print_dot) {
-      auto &f = I->second.first;
-      ofstream file(f.getName() + '.' + to_string(I->second.second) + ".dot");
+      auto &f = *saved.fn;
+      ofstream file(f.getName() + '.' + to_string(saved.dot_count) + ".dot");
       CFG cfg(f);
       cfg.printDot(file);
-      ofstream fileDom(f.getName() + '.' + to_string(I->second.second++) +
+      ofstream fileDom(f.getName() + '.' + to_string(saved.dot_count++) +
                        ".dom.dot");
       DomTree(f, cfg).printDot(fileDom);
     }
 
-    if (first)
+    if (first) {
+      save_fn(F, saved);
       return false;
+    }
 
     smt_init->reset();
     Transform t;
-    t.src = move(old_fn);
-    t.tgt = move(I->second.first);
+    t.src = move(*old_fn);
+    t.tgt = move(*saved.fn);
     t.preprocess();
     TransformVerify verifier(t, false);
     t.print(*out, print_opts);
@@ -216,7 +427,8 @@ struct TVPass final : public llvm::FunctionPass {
       *out << "Transformation seems to be correct!\n\n";
     }
 
-    I->second.first = move(t.tgt);
+    saved.fn = move(t.tgt);
+    save_fn(F, saved);
     return false;
   }
 
@@ -277,12 +489,18 @@ struct TVPass final : public llvm::FunctionPass {
     smt::solver_tactic_verbose(opt_tactic_verbose);
     smt::set_query_timeout(to_string(opt_smt_to));
     smt::set_random_seed(to_string(opt_smt_random_seed));
+    smt::set_bitcount_encoding(opt_bitcount_enc);
+    smt::solver_set_external(smt::QueryClass::QF_BV, opt_smt_qfbv_solver);
+    smt::solver_set_external(smt::QueryClass::Other, opt_smt_solver);
+    smt::solver_set_aig(opt_smt_aig || opt_smt_aig_sweep, opt_smt_aig_sweep);
     smt::set_memory_limit(opt_max_mem * 1024 * 1024);
     config::skip_smt = opt_smt_skip;
     config::io_nobuiltin = opt_io_nobuiltin;
     config::symexec_print_each_value = opt_se_verbose;
     config::disable_undef_input = opt_disable_undef_input;
     config::disable_poison_input = opt_disable_poison_input;
+    config::memory_soa = opt_memory_soa;
+    config::axiom_stats = opt_axiom_stats;
     config::debug = opt_debug;
     llvm_util::omit_array_size = opt_omit_array_size;
 
@@ -296,15 +514,32 @@ struct TVPass final : public llvm::FunctionPass {
       showed_stats = true;
       if (opt_smt_stats)
         smt::solver_print_stats(*out);
+      if (opt_axiom_stats)
+        tools::print_axiom_stats(*out);
       if (opt_alias_stats)
         IR::Memory::printAliasStats(cout);
+      if (opt_saved_fns_mem)
+        *out << "Saved functions: " << num_spilled << " spilled to disk, "
+             << num_reloaded << " reloaded, " << num_reload_failed
+             << " failed to reload\n";
       if (has_failure && !report_filename.empty())
         cerr << "Report written to " << report_filename << endl;
     }
 
     llvm_util_init.reset();
     smt_init.reset();
-    --initialized;
+    if (--initialized == 0) {
+      for (auto I = fns.begin(); I != fns.end(); ) {
+        if (I->second.fn)
+          ++I;
+        else
+          forget_fn(I++);
+      }
+      if (reload_ctx) {
+        llvm_util::forget_types(*reload_ctx);
+        reload_ctx.reset();
+      }
+    }
 
     if (has_failure) {
       cerr << "Alive2: Transform doesn't verify; aborting!" << endl;
@@ -15,6 +15,8 @@ bool skip_smt = false;
 bool io_nobuiltin = false;
 bool disable_poison_input = false;
 bool disable_undef_input = false;
+bool memory_soa = false;
+bool axiom_stats = false;
 bool debug = false;
 
 ostream &dbg() {
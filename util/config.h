@@ -17,6 +17,12 @@ extern bool disable_poison_input;
 
 extern bool disable_undef_input;
 
+// keep data, non-poison and pointer bits of memory in separate arrays
+extern bool memory_soa;
+
+// track which axioms are needed to prove refinement
+extern bool axiom_stats;
+
 extern bool debug;
 
 std::ostream &dbg();
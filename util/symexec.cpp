@@ -62,6 +62,8 @@ void sym_exec(State &s) {
     first = false;
   }
 
+  s.finishExecution();
+
   if (config::symexec_print_each_value) {
     cout << "domain = " << s.functionDomain()
          << "\nreturn domain = " << s.returnDomain()